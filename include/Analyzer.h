@@ -1,17 +1,137 @@
 #ifndef ANALYZER_H
 #define ANALYZER_H
 
+#include <cstdint>
+#include <span>
 #include <vector>
+#include "ConcurrentStore.h"
 #include "Measurement.h"
+#include "MeasurementColumns.h"
+#include "QuantileSketch.h"
+#include "TimeIndex.h"
 
 class Analyzer {
 public:
+    // Parallel splits columns into fixed 64 KiB tiles reduced on the shared
+    // ThreadPool and combined in tile order, so results do not depend on
+    // the thread count. Columns under PARALLEL_MIN_VALUES are reduced on the
+    // calling thread, tile by tile, and give the same result.
+    enum class Execution {
+        Serial,
+        Parallel
+    };
+
+    static constexpr size_t PARALLEL_MIN_VALUES = 256 * 1024;
+
+    // Running statistics for one field (Welford's update). The variance is
+    // the population variance of the values added so far. NaN values are
+    // skipped, here and in every other summary of the data.
+    struct FieldStats {
+        size_t count = 0;
+        double mean = 0.0;
+        double m2 = 0.0;
+        float min = 0.0f;
+        float max = 0.0f;
+
+        void add(float value);
+        void merge(const FieldStats& other);
+        double variance() const;
+    };
+
+    struct Summary {
+        FieldStats temperature;
+        FieldStats humidity;
+        FieldStats windSpeed;
+
+        void add(const Measurement& m);
+        void add(float temperature, float humidity, float windSpeed);
+        void merge(const Summary& other);
+        // Values in the fullest field; 0 only when every field is empty
+        size_t count() const;
+    };
+
+    // Per-sample statistics over the trailing window (t - window, t] of each
+    // sample, one output column per statistic
+    struct RollingColumns {
+        std::vector<float> mean;
+        std::vector<float> min;
+        std::vector<float> max;
+    };
+
+    enum class Bucket {
+        Hour,
+        Day,
+        Week,
+        Month
+    };
+
+    // One row of a group-by: the bucket's first minute and its statistics
+    struct Group {
+        int64_t start = 0;
+        Summary summary;
+    };
+
+    struct Percentiles {
+        float p50 = 0.0f;
+        float p95 = 0.0f;
+        float p99 = 0.0f;
+    };
+
+    // Every statistic for every field in one pass over the data
+    static Summary summarize(const std::vector<Measurement>& data);
+    static Summary summarize(const MeasurementColumns& columns);
+    static Summary summarize(const MeasurementColumns& columns, Execution execution);
+    static Summary summarize(const TimeRange& data);
+    // Same result as summarize(columns, Execution::Parallel) over the snapshot's rows
+    static Summary summarize(const ConcurrentStore::Snapshot& snapshot);
+
     static float averageTemperature(const std::vector<Measurement>& data);
     static float minTemperature(const std::vector<Measurement>& data);
     static float maxTemperature(const std::vector<Measurement>& data);
     static float averageHumidity(const std::vector<Measurement>& data);
     static float averageWindSpeed(const std::vector<Measurement>& data);
+
+    // Time-window versions, for views from WeatherStation::range
+    static float averageTemperature(const TimeRange& data);
+    static float minTemperature(const TimeRange& data);
+    static float maxTemperature(const TimeRange& data);
+    static float averageHumidity(const TimeRange& data);
+    static float averageWindSpeed(const TimeRange& data);
+
+    // Rolling mean / min / max in O(n) for the whole series: monotonic
+    // queues for min and max, a running sum for the mean. Timestamps must be
+    // ascending; windowMinutes is e.g. Timestamp::MINUTES_PER_DAY, and
+    // anything below 1 is treated as 1. NaN samples are skipped: they count
+    // towards no window, and a window holding nothing else gives NaN.
+    static RollingColumns rolling(std::span<const int64_t> timestamps, std::span<const float> values,
+                                  int64_t windowMinutes);
+    static RollingColumns rolling(const TimeRange& series, float (Measurement::*field)() const,
+                                  int64_t windowMinutes);
+
+    // Group-by on calendar buckets of the packed timestamp, one pass over
+    // the rows, groups in ascending order. Columns need not be sorted; large
+    // ones are split across threads and the per-thread groups merged.
+    static std::vector<Group> groupBy(const MeasurementColumns& columns, Bucket bucket);
+    static std::vector<Group> groupBy(const TimeRange& data, Bucket bucket);
+    static int64_t bucketStart(int64_t timestamp, Bucket bucket);
+
+    // Approximate percentiles in bounded memory (see QuantileSketch for the
+    // error bound). Sketch chunks separately and merge them to combine.
+    static QuantileSketch sketch(std::span<const float> values);
+    static Percentiles percentiles(const QuantileSketch& sketch);
+    static Percentiles percentiles(std::span<const float> values);
+
     static void displayStats(const std::vector<Measurement>& data);
+    static void displayStats(const Summary& summary);
+    static void displayPercentiles(const MeasurementColumns& columns);
+
+    // Single-column versions, meant for MeasurementColumns spans
+    static float average(std::span<const float> values);
+    static float minimum(std::span<const float> values);
+    static float maximum(std::span<const float> values);
+    static float average(std::span<const float> values, Execution execution);
+    static float minimum(std::span<const float> values, Execution execution);
+    static float maximum(std::span<const float> values, Execution execution);
 };
 
 #endif
@@ -0,0 +1,91 @@
+#ifndef COMPRESSEDARCHIVE_H
+#define COMPRESSEDARCHIVE_H
+
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+#include "MeasurementColumns.h"
+
+// Compressed time-series file for long histories, in independent blocks of
+// up to BLOCK_ROWS rows. Inside a block each field is its own stream:
+//   timestamps   delta-of-delta, 1 bit per row for a steady sample rate
+//   ids          zigzag varint of the difference to the previous id
+//   floats       Gorilla XOR against the previous value of the same field;
+//                1 bit for a repeated value, else only the changed bits
+//
+// Writer encodes one block at a time while rows stream in; load() checks
+// each block's CRC-32 and decodes the blocks in parallel on the ThreadPool.
+//
+// Since version 2 the header points at a block index at the end of the
+// file, so update() can append just the blocks that changed plus a new
+// index and leave every other block where it is.
+class CompressedArchive {
+public:
+    static constexpr uint32_t VERSION = 2;
+    static constexpr size_t BLOCK_ROWS = 8192;
+
+    // Where each block of a file lives. Block b holds rows
+    // [b * BLOCK_ROWS, (b + 1) * BLOCK_ROWS) of the columns it was saved from.
+    struct BlockIndex {
+        struct Entry {
+            uint64_t offset;    // of the block's frame
+            uint32_t rows;
+            uint32_t bytes;     // payload, not counting the frame
+        };
+        std::vector<Entry> blocks;
+        uint64_t indexOffset = 0;   // 0 for version 1 files, which have no index
+        uint64_t fileBytes = 0;
+    };
+
+    class Writer {
+    private:
+        std::ofstream file;
+        std::string filename;
+        MeasurementColumns pending;
+        std::vector<uint8_t> encoded;
+        BlockIndex index;
+        uint64_t rows = 0;
+        bool failed = false;
+
+        void flushBlock();
+
+    public:
+        ~Writer();
+
+        // Writes to filename + ".tmp" until close() atomically replaces
+        // filename with it (FileSync::replace); a failed close keeps the old file
+        bool open(const std::string& filename);
+        void append(const Measurement& m);
+        bool close();
+        // Valid after a successful close()
+        const BlockIndex& getIndex() const;
+    };
+
+    // One block's payload. The spans must hold the same number of rows.
+    static void encodeBlock(std::span<const int64_t> timestamps, std::span<const int> ids,
+                            std::span<const float> temperatures, std::span<const float> humidities,
+                            std::span<const float> windSpeeds, std::vector<uint8_t>& out);
+    // Decodes rows rows into the output arrays; false if the payload is malformed
+    static bool decodeBlock(const uint8_t* begin, const uint8_t* end, size_t rows, int64_t* timestamps,
+                            int* ids, float* temperatures, float* humidities, float* windSpeeds);
+
+    static bool isArchive(const char* begin, const char* end);
+    static bool isArchiveFile(const std::string& filename);
+
+    static bool save(const std::string& filename, const MeasurementColumns& columns, BlockIndex* index = nullptr);
+    // Leaves columns untouched and returns false on any corruption
+    static bool load(const char* begin, const char* end, MeasurementColumns& columns, BlockIndex* index = nullptr);
+    // Brings filename, last written or loaded with index, up to date with
+    // columns by rewriting only the blocks flagged in dirty (plus any whose
+    // row count changed). The new blocks and index are appended and synced
+    // before the header is switched over, so a crash leaves the old
+    // contents readable. Once dead blocks would make up more than half the
+    // file it is compacted with save() instead. False if the file no
+    // longer matches index; the caller should then save() in full.
+    static bool update(const std::string& filename, const MeasurementColumns& columns,
+                       const std::vector<bool>& dirty, BlockIndex& index);
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef CONCURRENTSTORE_H
+#define CONCURRENTSTORE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+#include "Measurement.h"
+
+// Measurements in fixed-size column chunks. One thread writes; a Snapshot
+// taken on any thread keeps its rows unchanged and is read without locks.
+class ConcurrentStore {
+public:
+    static constexpr size_t CHUNK_ROWS = 16 * 1024;
+
+    struct Chunk {
+        int64_t timestamps[CHUNK_ROWS];
+        int ids[CHUNK_ROWS];
+        float temperatures[CHUNK_ROWS];
+        float humidities[CHUNK_ROWS];
+        float windSpeeds[CHUNK_ROWS];
+    };
+
+    struct ChunkView {
+        std::span<const int64_t> timestamps;
+        std::span<const int> ids;
+        std::span<const float> temperatures;
+        std::span<const float> humidities;
+        std::span<const float> windSpeeds;
+    };
+
+private:
+    struct Directory {
+        std::vector<std::shared_ptr<Chunk>> chunks;
+        // Rows [0, rows) are published; the writer bumps it after filling a row
+        std::atomic<size_t> rows{0};
+    };
+
+public:
+    class Snapshot {
+    private:
+        std::shared_ptr<const Directory> directory;
+        size_t rows = 0;
+
+    public:
+        Snapshot() = default;
+        Snapshot(std::shared_ptr<const Directory> directory, size_t rows);
+
+        size_t size() const;
+        bool empty() const;
+        Measurement row(size_t slot) const;
+        // Chunk c holds slots [c * CHUNK_ROWS, ...); the last one may be partial
+        size_t chunkCount() const;
+        ChunkView chunk(size_t c) const;
+    };
+
+private:
+    // Writers take turns; publishMutex only guards copying published
+    std::mutex writeMutex;
+    std::shared_ptr<Directory> current;
+    mutable std::mutex publishMutex;
+    std::shared_ptr<Directory> published;
+
+    void publish(std::shared_ptr<Directory> directory);
+    static std::shared_ptr<Chunk> copyChunk(const Chunk& chunk);
+    static void writeRow(Chunk& chunk, size_t index, const Measurement& m);
+
+public:
+    ConcurrentStore();
+
+    ConcurrentStore(const ConcurrentStore&) = delete;
+    ConcurrentStore& operator=(const ConcurrentStore&) = delete;
+
+    void append(const Measurement& m);
+    void append(std::span<const Measurement> rows);
+    // Same as MeasurementColumns::erase; snapshots taken before keep the row
+    void erase(size_t slot);
+    // Replaces every row; snapshots taken before keep the old rows
+    void assign(std::span<const Measurement> rows);
+
+    // Safe from any thread
+    Snapshot snapshot() const;
+    size_t size() const;
+};
+
+#endif
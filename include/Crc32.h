@@ -0,0 +1,14 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32 (IEEE 802.3, the zlib / PNG polynomial). Pass the previous result
+// as crc to checksum data that arrives in pieces.
+class Crc32 {
+public:
+    static uint32_t compute(const void* data, size_t size, uint32_t crc = 0);
+};
+
+#endif
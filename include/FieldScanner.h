@@ -0,0 +1,26 @@
+#ifndef FIELDSCANNER_H
+#define FIELDSCANNER_H
+
+#include <cstdint>
+#include <vector>
+
+// Builds a structural index of a text block: the offset of every ';' and
+// '\n', in order. The widest kernel the CPU supports is picked at runtime.
+class FieldScanner {
+public:
+    enum class Kernel {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    static Kernel bestKernel();
+    static const char* kernelName(Kernel kernel);
+
+    // Offsets are relative to begin, so a block must be smaller than 4 GiB.
+    // The index is cleared first.
+    static void buildIndex(const char* begin, const char* end, std::vector<uint32_t>& index);
+    static void buildIndex(const char* begin, const char* end, std::vector<uint32_t>& index, Kernel kernel);
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef FILESYNC_H
+#define FILESYNC_H
+
+#include <cstdio>
+#include <string>
+
+// Making files durable, for the snapshot, archive and journal writers.
+// A file is only on disk once its data is flushed and, for a new or
+// renamed file, once its directory entry is too.
+class FileSync {
+public:
+    // fflush, then fsync (_commit on Windows)
+    static bool flush(FILE* file);
+    static bool syncFile(const std::string& path);
+    // Makes creations, renames and deletes in path's directory durable.
+    // Windows has no directory fsync; there it always succeeds.
+    static bool syncDirectory(const std::string& path);
+
+    // Atomically puts temporary in target's place, replacing any old
+    // target: temporary is synced, renamed over target (MoveFileExW with
+    // write-through on Windows) and the directory synced. Nothing is
+    // deleted on failure, so the old target and temporary both survive.
+    static bool replace(const std::string& temporary, const std::string& target);
+};
+
+#endif
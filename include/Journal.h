@@ -0,0 +1,96 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MeasurementColumns.h"
+
+// Append-only write-ahead log next to a snapshot, all under one base path:
+//   <base>.wsnap                 snapshot, its sequence = last LSN it covers
+//   <base>.wal.<first LSN>       log segments, fixed 40-byte records
+//
+// append() only queues a record. A writer thread flushes whatever queued
+// up since its last write with a single fsync (group commit), so callers
+// never wait on the disk unless they call sync(). checkpoint() writes a
+// snapshot of the given columns on a background thread and then deletes
+// the segments it covers; a failed checkpoint deletes nothing. open()
+// returns the snapshot and every logged record after it; a torn record at
+// the end of the log is cut off.
+class Journal {
+public:
+    enum class RecordType : uint32_t {
+        Add = 1,
+        Delete = 2
+    };
+
+    struct Record {
+        uint64_t lsn;
+        RecordType type;
+        Measurement measurement;
+    };
+
+    static constexpr uint64_t SEGMENT_BYTES = 16 * 1024 * 1024;
+    static constexpr uint64_t CHECKPOINT_BYTES = 64 * 1024 * 1024;
+
+private:
+    std::string basePath;
+    bool isOpen = false;
+
+    // Guarded by mutex
+    std::mutex mutex;
+    std::condition_variable queued;
+    std::condition_variable durable;
+    std::vector<unsigned char> buffer;
+    uint64_t nextLsn = 1;
+    uint64_t durableLsn = 0;
+    uint64_t bytesSinceCheckpoint = 0;
+    bool rotateRequested = false;
+    bool stopping = false;
+    bool writeFailed = false;
+    uint64_t currentSegment = 0;    // first LSN of the segment being written
+
+    std::thread writer;
+    std::thread checkpointer;
+    std::atomic<bool> checkpointRunning{false};
+    // Set when a checkpoint fails, cleared when a later one succeeds
+    std::atomic<bool> checkpointFailed{false};
+
+    // Writer thread only
+    FILE* segment = nullptr;
+    uint64_t segmentBytes = 0;
+
+    std::string segmentName(uint64_t firstLsn) const;
+    std::vector<std::pair<uint64_t, std::string>> listSegments() const;
+    void writerLoop();
+    void writeCheckpoint(MeasurementColumns columns, uint64_t lsn);
+
+public:
+    ~Journal();
+
+    bool open(const std::string& basePath, MeasurementColumns& snapshot, std::vector<Record>& tail);
+    // Flushes everything queued, waits for a running checkpoint, stops the threads
+    void close();
+
+    uint64_t append(RecordType type, const Measurement& m);
+    // Blocks until every record appended so far is on disk; false after a
+    // write error or while the last checkpoint has failed
+    bool sync();
+
+    uint64_t lastLsn();
+    bool checkpointDue();
+    // Snapshot of columns as of lastLsn(), written in the background.
+    // Returns false if the previous checkpoint is still running.
+    bool checkpoint(MeasurementColumns columns);
+    // False if the last checkpoint failed
+    bool waitForCheckpoint();
+
+    const std::string& getBasePath() const;
+};
+
+#endif
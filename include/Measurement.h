@@ -1,25 +1,30 @@
 #ifndef MEASUREMENT_H
 #define MEASUREMENT_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
+// Fixed 24-byte, trivially copyable record. Date and time are packed into
+// one timestamp (minutes since the epoch, see Timestamp) and only turned
+// back into "DD/MM/YYYY" / "HH:MM" text on demand.
 class Measurement {
 private:
+    int64_t timestamp;
     int id;
     float temperature;
     float humidity;
     float windSpeed;
-    std::string date;
-    std::string time;
 
 public:
     Measurement();
-    Measurement(int id, float temp, float hum, float wind, std::string d, std::string t);
+    Measurement(int id, float temp, float hum, float wind, int64_t timestamp);
 
     int getId() const;
     float getTemperature() const;
     float getHumidity() const;
     float getWindSpeed() const;
+    int64_t getTimestamp() const;
     std::string getDate() const;
     std::string getTime() const;
 
@@ -27,11 +32,18 @@ public:
     void setTemperature(float temp);
     void setHumidity(float hum);
     void setWindSpeed(float wind);
-    void setDate(std::string d);
-    void setTime(std::string t);
+    void setTimestamp(int64_t timestamp);
+    // False, and the timestamp unchanged, unless the text parses (see Timestamp)
+    bool setDate(std::string d);
+    bool setTime(std::string t);
+
+    // Longest line formatTextLine can produce, terminator not included
+    static constexpr size_t MAX_TEXT_LINE = 96;
 
     void display() const;
     std::string toTextLine() const;
+    // Writes the toTextLine() text (no newline) to out and returns its end
+    char* formatTextLine(char* out) const;
 };
 
 #endif
@@ -0,0 +1,42 @@
+#ifndef MEASUREMENTCOLUMNS_H
+#define MEASUREMENTCOLUMNS_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "Measurement.h"
+
+// Structure-of-arrays copy of the station's measurements: one contiguous
+// array per field, so a scan over a single field touches only that field.
+// Slot i in every column belongs to the same measurement.
+class MeasurementColumns {
+private:
+    std::vector<int> ids;
+    std::vector<float> temperatures;
+    std::vector<float> humidities;
+    std::vector<float> windSpeeds;
+    std::vector<int64_t> timestamps;
+
+public:
+    void clear();
+    void reserve(size_t count);
+    void append(const Measurement& m);
+    // Removes slot; the later rows move down one
+    void erase(size_t slot);
+    void assign(const std::vector<Measurement>& measurements);
+    // Takes over whole columns; all five must have the same length
+    void assign(std::vector<int>&& newIds, std::vector<float>&& newTemperatures, std::vector<float>&& newHumidities,
+                std::vector<float>&& newWindSpeeds, std::vector<int64_t>&& newTimestamps);
+
+    size_t size() const;
+    bool empty() const;
+    Measurement row(size_t slot) const;
+
+    std::span<const int> getIds() const;
+    std::span<const float> getTemperatures() const;
+    std::span<const float> getHumidities() const;
+    std::span<const float> getWindSpeeds() const;
+    std::span<const int64_t> getTimestamps() const;
+};
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef MEASUREMENTPARSER_H
+#define MEASUREMENTPARSER_H
+
+#include <vector>
+#include "Measurement.h"
+
+// Parses the ';'-separated text format straight out of a memory buffer.
+// Mirrors the stream loader: empty lines are skipped, unparsable numbers
+// become 0 and a missing time column defaults to "00:00". A line without a
+// valid date, or with a time column that does not parse, is rejected:
+// skipped and counted in rejected when that is given.
+class MeasurementParser {
+public:
+    static bool parseLine(const char* begin, const char* end, Measurement& out);
+    static size_t parseBuffer(const char* begin, const char* end, std::vector<Measurement>& out,
+                              size_t* rejected = nullptr);
+
+    // Splits the buffer at line boundaries and parses the chunks on the
+    // shared ThreadPool. Records are appended to out in their original order.
+    // threadCount caps the number of chunks; 0 means one per pool thread.
+    static size_t parseBufferParallel(const char* begin, const char* end, std::vector<Measurement>& out,
+                                      unsigned threadCount = 0, size_t* rejected = nullptr);
+};
+
+#endif
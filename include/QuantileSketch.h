@@ -0,0 +1,57 @@
+#ifndef QUANTILESKETCH_H
+#define QUANTILESKETCH_H
+
+#include <cstdint>
+#include <random>
+#include <span>
+#include <vector>
+
+// KLL streaming quantile sketch (Karnin, Lang & Liberty, 2016).
+//
+// Values enter level 0; when the sketch is over budget, the first full
+// level is sorted and every other item (random offset) moves up a level
+// with twice the weight. Level h holds at most k * (2/3)^(top - h) items
+// (never fewer than 8), so memory stays around 3k floats plus a few
+// compactors, however many values are added.
+//
+// Error guarantee: quantile(q) returns a value whose true rank lies within
+// about epsilon() * size() of q * size() (epsilon() ~ 1.3% at the default
+// k = 200, with 99% confidence). Larger k trades memory for accuracy.
+// Sketches built with the same k over separate chunks or threads can be
+// merged and keep that guarantee for the combined data; merge() refuses a
+// sketch with a different k.
+class QuantileSketch {
+private:
+    int k;
+    size_t count;
+    size_t retained;
+    float minValue;
+    float maxValue;
+    std::vector<std::vector<float>> levels;
+    // Per-level budgets and their sum, recomputed only when a level is added
+    std::vector<size_t> capacities;
+    size_t totalCapacity;
+    std::minstd_rand coin;
+
+    void updateCapacities();
+    void compressWhileFull();
+
+public:
+    static const int DEFAULT_K = 200;
+
+    explicit QuantileSketch(int k = DEFAULT_K);
+
+    void add(float value);
+    void add(std::span<const float> values);
+    // False, leaving this sketch unchanged, if other was built with another k
+    bool merge(const QuantileSketch& other);
+
+    size_t size() const;
+    bool empty() const;
+    double epsilon() const;
+
+    float quantile(double q) const;
+    std::vector<float> quantiles(const std::vector<double>& qs) const;
+};
+
+#endif
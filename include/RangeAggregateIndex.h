@@ -0,0 +1,58 @@
+#ifndef RANGEAGGREGATEINDEX_H
+#define RANGEAGGREGATEINDEX_H
+
+#include <vector>
+#include "TimeIndex.h"
+
+// Segment trees over the temperature, humidity and wind series in time
+// order. Any window [first, last) of positions answers count / sum / min /
+// max in O(log n); appending a sample updates one leaf-to-root path.
+// NaN samples hold a position but are left out of every aggregate.
+class RangeAggregateIndex {
+public:
+    enum class Field {
+        Temperature,
+        Humidity,
+        WindSpeed
+    };
+
+    struct Aggregate {
+        size_t count = 0;
+        double sum = 0.0;
+        float min = 0.0f;
+        float max = 0.0f;
+
+        double mean() const;
+    };
+
+private:
+    struct Node {
+        size_t count;
+        double sum;
+        float min;
+        float max;
+    };
+
+    static const Node EMPTY;
+
+    static const int FIELD_COUNT = 3;
+
+    size_t count = 0;
+    size_t leaves = 0;     // power of two, leaves live at [leaves, 2 * leaves)
+    std::vector<Node> trees[FIELD_COUNT];
+
+    void grow(size_t minimum);
+    void setLeaf(int field, size_t position, float value);
+    static Node leaf(float value);
+    static Node combine(const Node& l, const Node& r);
+
+public:
+    void clear();
+    void build(const TimeRange& series);
+    void append(const Measurement& m);
+
+    size_t size() const;
+    Aggregate query(Field field, size_t first, size_t last) const;
+};
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef REDUCTIONS_H
+#define REDUCTIONS_H
+
+#include <cstddef>
+#include <span>
+
+// Fused sum / M2 (sum of squared deviations from the mean) / min / max over
+// a float column, vectorized with AVX2 or AVX-512 when the CPU has them
+// (picked once at runtime). NaN values are skipped and not counted.
+//
+// Columns are reduced in blocks of BLOCK_VALUES. Each block sums the
+// deviations from one of its own values, which keeps its M2 accurate for
+// data far from zero (humidity near 100), and blocks are merged in order
+// with Chan's formula. Every kernel splits a block into the same 16
+// double-precision lanes (element i goes to lane i % 16) and folds the
+// lanes in the same order, so all kernels return bit-identical results for
+// the same input.
+//
+// Sums are compensated (Kahan per lane, Neumaier across lanes) unless Fast
+// is asked for, or the build defines WEATHER_STATION_FAST_SUMMATION. The
+// compensated error bound does not grow with the column length, unlike the
+// plain sum's.
+class Reductions {
+public:
+    static constexpr size_t BLOCK_VALUES = 16 * 1024;
+    enum class Kernel {
+        Portable,
+        AVX2,
+        AVX512
+    };
+
+    enum class Summation {
+        Fast,
+        Compensated
+    };
+
+    static constexpr Summation DEFAULT_SUMMATION =
+#ifdef WEATHER_STATION_FAST_SUMMATION
+        Summation::Fast;
+#else
+        Summation::Compensated;
+#endif
+
+    // Scalar Neumaier sum, for callers that cannot hand over a contiguous column
+    class Accumulator {
+    private:
+        double sum = 0.0;
+        double compensation = 0.0;
+
+    public:
+        void add(double value);
+        double value() const;
+    };
+
+    struct Result {
+        size_t count = 0;
+        double sum = 0.0;
+        double m2 = 0.0;
+        float min = 0.0f;
+        float max = 0.0f;
+
+        double mean() const;
+        // Population variance
+        double variance() const;
+    };
+
+    // Min and max alone, for callers that need nothing else: a pass with no
+    // sums, same values as reduce() gives. Both are 0 when empty.
+    struct Extremes {
+        bool empty = true;
+        float min = 0.0f;
+        float max = 0.0f;
+
+        // Merges the next part of the column, like Combiner
+        void add(const Extremes& part);
+    };
+
+    // Merges results of consecutive parts of a column, in the order added.
+    // A single part comes back unchanged.
+    class Combiner {
+    private:
+        Result result;
+        Accumulator sum;
+
+    public:
+        void add(const Result& part);
+        Result value() const;
+    };
+
+    static Kernel bestKernel();
+    static const char* kernelName(Kernel kernel);
+
+    static Result reduce(std::span<const float> values, Summation summation = DEFAULT_SUMMATION);
+    static Result reduce(std::span<const float> values, Kernel kernel, Summation summation = DEFAULT_SUMMATION);
+
+    static Extremes extremes(std::span<const float> values);
+    static Extremes extremes(std::span<const float> values, Kernel kernel);
+
+    static double sum(std::span<const float> values);
+    static double variance(std::span<const float> values);
+    static float min(std::span<const float> values);
+    static float max(std::span<const float> values);
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef ROLLUPCACHE_H
+#define ROLLUPCACHE_H
+
+#include <cstdint>
+#include <map>
+#include <vector>
+#include "Analyzer.h"
+#include "TimeIndex.h"
+
+// Pre-aggregated summaries per hour, day and month, keyed by the bucket's
+// first minute. A window query is split into whole buckets, coarsest
+// first: a year-long window touches a dozen month entries and a few dozen
+// finer ones at its edges. Only the partial hours at the two ends are read
+// from the rows themselves; minutes are the timestamp resolution, so a
+// minute level would just be a second copy of the rows.
+class RollupCache {
+public:
+    enum class Level {
+        Hour,
+        Day,
+        Month
+    };
+
+    typedef std::map<int64_t, Analyzer::Summary> Buckets;
+
+private:
+    static const int LEVEL_COUNT = 3;
+
+    Buckets levels[LEVEL_COUNT];
+
+    void store(int level, int64_t start, const Analyzer::Summary& summary);
+
+public:
+    static int64_t bucketStart(int64_t timestamp, Level level);
+    static int64_t bucketEnd(int64_t start, Level level);
+
+    void clear();
+    // series must be in time order, e.g. a TimeRange over every row
+    void rebuild(const TimeRange& series);
+    void add(const Measurement& m);
+    // Recomputes every bucket holding timestamp after rows were removed;
+    // hourRows are the rows now stored in that timestamp's hour
+    void refresh(int64_t timestamp, const TimeRange& hourRows);
+
+    const Buckets& buckets(Level level) const;
+    // Statistics of the rows with from <= timestamp < to
+    Analyzer::Summary query(int64_t from, int64_t to, const TimeIndex& index,
+                            const std::vector<Measurement>& measurements) const;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef RUNNINGSTATS_H
+#define RUNNINGSTATS_H
+
+#include <map>
+#include <vector>
+#include "Analyzer.h"
+#include "Measurement.h"
+
+// Aggregates kept up to date as measurements come and go, so statistics
+// never need a pass over the data. Count, mean and variance use Welford
+// updates (O(1) add and remove). Min and max come from an ordered
+// value -> multiplicity map (O(log d) for d distinct values), which also
+// survives deletes. NaN values are left out of every aggregate.
+class RunningStats {
+private:
+    struct Field {
+        size_t count = 0;
+        double mean = 0.0;
+        double m2 = 0.0;
+        std::map<float, size_t> values;
+
+        void addMoments(float value);
+        void add(float value);
+        void remove(float value);
+        void rebuild(const std::vector<Measurement>& measurements, float (Measurement::*get)() const);
+        Analyzer::FieldStats stats() const;
+    };
+
+    Field temperature;
+    Field humidity;
+    Field windSpeed;
+
+public:
+    void add(const Measurement& m);
+    void remove(const Measurement& m);
+    void clear();
+    void rebuild(const std::vector<Measurement>& measurements);
+
+    Analyzer::Summary summary() const;
+};
+
+#endif
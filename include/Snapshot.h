@@ -0,0 +1,36 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+#include "MeasurementColumns.h"
+
+// Versioned binary snapshot of the measurement columns.
+//
+// Layout (little-endian):
+//   header      magic, version, column count, row count, sequence, CRC-32
+//               of header + directory
+//   directory   per column: kind, element size, offset, byte length, CRC-32
+//   columns     each one contiguous array, starting on a 64-byte boundary
+//
+// Loading checks every length and checksum against the mapped bytes and
+// then copies each column in one block, with no per-row parsing. The
+// sequence number is stored for the journal; plain saves write 0.
+class Snapshot {
+public:
+    static constexpr uint32_t VERSION = 1;
+
+    static bool isSnapshot(const char* begin, const char* end);
+    static bool isSnapshotFile(const std::string& filename);
+
+    // Writes to filename + ".tmp" and atomically replaces filename with it
+    // (see FileSync::replace), so a crash or a failed save never leaves a
+    // half-written snapshot behind or loses the previous one
+    static bool save(const std::string& filename, const MeasurementColumns& columns, uint64_t sequence = 0);
+    // Leaves columns untouched and returns false on any corruption
+    static bool load(const char* begin, const char* end, MeasurementColumns& columns,
+                     uint64_t* sequence = nullptr);
+    static bool load(const std::string& filename, MeasurementColumns& columns, uint64_t* sequence = nullptr);
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef TAILFOLLOWER_H
+#define TAILFOLLOWER_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "WeatherStation.h"
+
+// Follows a text measurement file that another process keeps appending to.
+// poll() parses only the bytes written since the previous call and adds
+// the complete lines to a station; a partial last line waits for its
+// newline. When the path starts naming a new file (rotation), the old one
+// is read to its end first and the new one is followed from byte 0. A file
+// that shrinks (truncated in place) is also read again from byte 0.
+//
+// wait() sleeps until the file may have changed: inotify on Linux, a plain
+// timeout elsewhere. A GUI calls poll() from a QTimer instead.
+class TailFollower {
+public:
+    static constexpr size_t READ_BYTES = 1024 * 1024;
+
+private:
+    std::string path;
+    std::ifstream file;
+    // Bytes of the followed file parsed so far; carry holds the partial
+    // line read after them, so the next read starts at offset + carry.size()
+    uint64_t offset = 0;
+    std::string carry;
+    // Identity of the open file, to spot rotation; 0 where the platform has none
+    uint64_t fileId = 0;
+    int notifyFd = -1;
+
+    bool reopen();
+    void readAppended(std::vector<Measurement>& parsed);
+
+public:
+    TailFollower() = default;
+    ~TailFollower();
+
+    TailFollower(const TailFollower&) = delete;
+    TailFollower& operator=(const TailFollower&) = delete;
+
+    // Starts at startOffset, which should be a line boundary: 0 to read the
+    // whole file, or getLastLoadStats().lineEnd after
+    // loadFromFile(filename, mode, true)
+    bool open(const std::string& filename, uint64_t startOffset = 0);
+    void close();
+    bool isOpen() const;
+
+    // Adds every complete line appended since the last call; returns how many
+    size_t poll(WeatherStation& station);
+    // False if nothing happened to the file within timeoutMs
+    bool wait(int timeoutMs);
+    uint64_t getOffset() const;
+};
+
+#endif
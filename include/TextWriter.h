@@ -0,0 +1,19 @@
+#ifndef TEXTWRITER_H
+#define TEXTWRITER_H
+
+#include <span>
+#include <string>
+#include "Measurement.h"
+
+// Bulk writer for the ';'-separated text format. Lines are formatted with
+// to_chars into one reusable buffer and written in CHUNK_BYTES pieces,
+// with no per-line flush. The bytes match a text-mode stream writing one
+// toTextLine() per row (CRLF line endings on Windows).
+class TextWriter {
+public:
+    static constexpr size_t CHUNK_BYTES = 1 << 20;
+
+    static bool write(const std::string& filename, std::span<const Measurement> rows);
+};
+
+#endif
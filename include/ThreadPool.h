@@ -0,0 +1,57 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker threads with one task deque each. A worker pops its
+// own newest task first and, when that runs dry, steals the oldest task
+// of another worker, so uneven tasks even out without a central queue.
+//
+// Threads that wait on parallelFor run queued tasks themselves instead of
+// blocking, so parallel code may call parallelFor again from inside a task.
+class ThreadPool {
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> nextQueue;
+    std::atomic<size_t> pending;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping;
+
+    bool runOne(size_t first);
+    void workerLoop(size_t self);
+
+public:
+    // threadCount == 0 leaves one hardware thread for the caller
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Process-wide pool, started on first use
+    static ThreadPool& shared();
+
+    size_t size() const;
+    void submit(std::function<void()> task);
+
+    // Calls body(i) for every i in [0, count) on the workers and the
+    // calling thread, and returns once all calls have finished. Indices are
+    // handed out dynamically, so the order in which they run is unspecified.
+    void parallelFor(size_t count, const std::function<void(size_t)>& body);
+};
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef TIMEINDEX_H
+#define TIMEINDEX_H
+
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include "Measurement.h"
+
+// Non-owning, time-ordered view of the measurements in a time window.
+// Only valid until the station is next modified.
+class TimeRange {
+public:
+    struct Entry {
+        int64_t timestamp;
+        size_t slot;
+    };
+
+    class iterator {
+    private:
+        const Entry* entry;
+        const Measurement* rows;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = Measurement;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Measurement*;
+        using reference = const Measurement&;
+
+        iterator() : entry(nullptr), rows(nullptr) {}
+        iterator(const Entry* entry, const Measurement* rows) : entry(entry), rows(rows) {}
+
+        reference operator*() const { return rows[entry->slot]; }
+        pointer operator->() const { return &rows[entry->slot]; }
+        reference operator[](difference_type n) const { return rows[entry[n].slot]; }
+
+        iterator& operator++() { ++entry; return *this; }
+        iterator operator++(int) { iterator old = *this; ++entry; return old; }
+        iterator& operator--() { --entry; return *this; }
+        iterator operator--(int) { iterator old = *this; --entry; return old; }
+        iterator& operator+=(difference_type n) { entry += n; return *this; }
+        iterator& operator-=(difference_type n) { entry -= n; return *this; }
+        iterator operator+(difference_type n) const { return iterator(entry + n, rows); }
+        iterator operator-(difference_type n) const { return iterator(entry - n, rows); }
+        friend iterator operator+(difference_type n, const iterator& it) { return it + n; }
+        difference_type operator-(const iterator& other) const { return entry - other.entry; }
+
+        bool operator==(const iterator& other) const { return entry == other.entry; }
+        bool operator!=(const iterator& other) const { return entry != other.entry; }
+        bool operator<(const iterator& other) const { return entry < other.entry; }
+        bool operator>(const iterator& other) const { return entry > other.entry; }
+        bool operator<=(const iterator& other) const { return entry <= other.entry; }
+        bool operator>=(const iterator& other) const { return entry >= other.entry; }
+    };
+
+private:
+    const Entry* first;
+    const Entry* last;
+    const Measurement* rows;
+
+public:
+    TimeRange(const Entry* first, const Entry* last, const Measurement* rows);
+
+    iterator begin() const;
+    iterator end() const;
+    size_t size() const;
+    bool empty() const;
+    const Measurement& operator[](size_t i) const;
+};
+
+// Slots of the station's measurements sorted by timestamp; ties keep insertion order
+class TimeIndex {
+private:
+    std::vector<TimeRange::Entry> entries;
+
+    std::vector<TimeRange::Entry>::iterator find(int64_t timestamp, size_t slot);
+
+public:
+    void clear();
+    void rebuild(const std::vector<Measurement>& measurements);
+    // Returns the position the entry landed at in time order
+    size_t insert(int64_t timestamp, size_t slot);
+    // Also moves every later slot down by one, as the rows are erased in place
+    void remove(int64_t timestamp, size_t slot);
+
+    // Measurements with from <= timestamp < to
+    TimeRange range(int64_t from, int64_t to, const std::vector<Measurement>& measurements) const;
+    // Same window as positions [first, second) in time order
+    std::pair<size_t, size_t> bounds(int64_t from, int64_t to) const;
+    size_t size() const;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <cstdint>
+#include <string>
+
+// Packed timestamps are minutes since 01/01/1970 00:00 of the station's
+// wall clock. No time zone is attached, like the text format.
+class Timestamp {
+public:
+    static constexpr int64_t MINUTES_PER_HOUR = 60;
+    static constexpr int64_t MINUTES_PER_DAY = 24 * 60;
+    static constexpr int64_t MINUTES_PER_WEEK = 7 * MINUTES_PER_DAY;
+
+    static int64_t fromCivil(int year, int month, int day, int hour = 0, int minute = 0);
+    static void toCivil(int64_t minutes, int& year, int& month, int& day, int& hour, int& minute);
+
+    // Split a timestamp into whole days since the epoch and the minute of that day
+    static int64_t dayNumber(int64_t minutes);
+    static int minuteOfDay(int64_t minutes);
+
+    // First minute of the calendar week (weeks start on Monday) or month
+    static int64_t startOfWeek(int64_t minutes);
+    static int64_t startOfMonth(int64_t minutes);
+
+    // "DD/MM/YYYY" to days since the epoch, "HH:MM" to minutes since midnight.
+    // All return false and leave the output untouched on anything but those
+    // exact widths, or a date the calendar does not have (31/02, 29/02
+    // outside leap years).
+    static bool parseDate(const char* begin, const char* end, int64_t& days);
+    static bool parseTime(const char* begin, const char* end, int& minutes);
+    static bool parse(const std::string& date, const std::string& time, int64_t& minutes);
+
+    // Write exactly 10 ("DD/MM/YYYY") or 5 ("HH:MM") characters, no terminator
+    static void formatDate(int64_t minutes, char* out);
+    static void formatTime(int64_t minutes, char* out);
+    static std::string dateString(int64_t minutes);
+    static std::string timeString(int64_t minutes);
+};
+
+#endif
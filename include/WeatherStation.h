@@ -1,21 +1,154 @@
 #ifndef WEATHERSTATION_H
 #define WEATHERSTATION_H
 
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
+#include <unordered_map>
 #include "Measurement.h"
+#include "CompressedArchive.h"
+#include "ConcurrentStore.h"
+#include "Journal.h"
+#include "MeasurementColumns.h"
+#include "RangeAggregateIndex.h"
+#include "RollupCache.h"
+#include "RunningStats.h"
+#include "TimeIndex.h"
 
 class WeatherStation {
+public:
+    enum class LoadMode {
+        Stream,     // std::getline based reader, the original implementation
+        Mapped,     // mmap the file and parse in place
+        Parallel    // Mapped, with chunks parsed on all hardware threads
+    };
+
+    enum class FileFormat {
+        Text,       // ';'-separated lines, one measurement per line
+        Snapshot,   // binary columns, see Snapshot
+        Archive     // compressed blocks, see CompressedArchive
+    };
+
+    struct LoadStats {
+        size_t bytes = 0;
+        // Text files: just past the last '\n'
+        size_t lineEnd = 0;
+        size_t records = 0;
+        // Text lines skipped for a missing or malformed date or time
+        size_t rejected = 0;
+        // Reading and parsing or decoding the file
+        double parseSeconds = 0.0;
+        // Rebuilding the columns, indexes, rollups and running statistics
+        double indexSeconds = 0.0;
+        // The whole load
+        double seconds = 0.0;
+
+        // Parse throughput: bytes / parseSeconds
+        double megabytesPerSecond() const;
+    };
+
 private:
     std::vector<Measurement> measurements;
+    MeasurementColumns columns;
+    // id -> slot in measurements; a multimap because files may repeat ids
+    std::unordered_multimap<int, size_t> idIndex;
+    RunningStats runningStats;
+    TimeIndex timeIndex;
+    // Built lazily; in-order appends keep it current, anything else marks it
+    // stale. The mutex serializes the lazy rebuild between const readers.
+    mutable std::mutex rangeAggregatesMutex;
+    mutable RangeAggregateIndex rangeAggregates;
+    mutable bool rangeAggregatesStale = true;
+    RollupCache rollups;
+    LoadStats lastLoad;
+    FileFormat fileFormat = FileFormat::Text;
+    std::unique_ptr<Journal> journal;
+    // Incremental archive saves: savedArchive matches the rows as of
+    // savedIndex except in dirtyBlocks (CompressedArchive::BLOCK_ROWS slots
+    // each). Saving does not change the station, hence mutable.
+    mutable std::string savedArchive;
+    mutable CompressedArchive::BlockIndex savedIndex;
+    mutable std::vector<bool> dirtyBlocks;
+    // Concurrent reads: a copy of the rows that other threads snapshot
+    ConcurrentStore store;
+    bool concurrentReads = false;
+
+    void markDirty(size_t slot);
+    void markDirtyFrom(size_t slot);
+    void removeAt(std::unordered_multimap<int, size_t>::iterator entry);
+    bool removeExact(const Measurement& m);
+    // Removes the rows whose slot is marked, keeping the order of the rest
+    size_t removeMarked(const std::vector<bool>& doomed);
+    void rowsFromColumns();
+    void logChange(Journal::RecordType type, const Measurement& m);
+    void checkpointIfDue();
+    // Rebuilds every index from the rows in parallel, and the running
+    // statistics too when asked
+    void rebuildIndexes(bool statistics = false);
+
+    bool loadStream(const std::string& filename, bool completeLines);
+    bool loadMapped(const std::string& filename, bool parallel, bool completeLines);
+    bool loadBinary(const std::string& filename, FileFormat format);
 
 public:
     void addMeasurement(const Measurement& m);
+    // Same as adding each row, in order
+    void addMeasurements(const std::vector<Measurement>& batch);
+    // Removes the first measurement in file order with this id; the other
+    // rows keep their order
     bool removeMeasurement(int id);
+    // Remove every measurement carrying one of the ids / matching the predicate, keeping the order
+    // of the rest; return the count removed
+    size_t removeMeasurements(const std::vector<int>& ids);
+    size_t removeIf(const std::function<bool(const Measurement&)>& predicate);
+    // By slot in getMeasurements(), for callers that show the rows in that
+    // order (the GUI table) and must not hit other rows sharing an id
+    bool removeMeasurementAt(size_t slot);
+    size_t removeMeasurementsAt(const std::vector<size_t>& slots);
     void displayAll() const;
-    bool loadFromFile(const std::string& filename);
+    // The format is detected from the file's first bytes; mode only applies to text.
+    // completeLines leaves out a last line without its '\n', for following
+    // the file from getLastLoadStats().lineEnd.
+    bool loadFromFile(const std::string& filename, LoadMode mode = LoadMode::Parallel, bool completeLines = false);
+    // Saves in the format of the last file loaded (text until then).
+    // Saving an archive over the one last loaded or saved only writes the
+    // blocks that changed since.
     bool saveToFile(const std::string& filename) const;
+    bool saveToFile(const std::string& filename, FileFormat format) const;
+    FileFormat getFileFormat() const;
     const std::vector<Measurement>& getMeasurements() const;
+    const MeasurementColumns& getColumns() const;
+    // Maintained incrementally, no pass over the data
+    Analyzer::Summary getStatistics() const;
+    // Statistics of the window [from, to), answered from the rollup cache
+    Analyzer::Summary getStatistics(int64_t from, int64_t to) const;
+    const RollupCache& getRollups() const;
+    // Measurements with from <= timestamp < to, oldest first; invalid after the next modification
+    TimeRange range(int64_t from, int64_t to) const;
+    // min / max / sum of one field over time-ordered positions [first, last) or the window [from, to);
+    // safe from several threads while nothing modifies the station
+    RangeAggregateIndex::Aggregate aggregatePositions(RangeAggregateIndex::Field field,
+                                                      size_t first, size_t last) const;
+    RangeAggregateIndex::Aggregate aggregateWindow(RangeAggregateIndex::Field field,
+                                                   int64_t from, int64_t to) const;
+    const LoadStats& getLastLoadStats() const;
+
+    // Replaces the contents with basePath's snapshot plus its log, then logs every add and delete.
+    // A load while the journal is open checkpoints; if that fails the load returns false.
+    bool openJournal(const std::string& basePath);
+    void closeJournal();
+    // Waits until every change so far is on disk; false after a write error
+    // or a failed checkpoint
+    bool syncJournal();
+    // Snapshot the current contents in the background and drop the log they cover
+    bool checkpoint();
+
+    // From here on snapshot() may be called from any thread while this one modifies the station;
+    // everything else stays single-threaded
+    void enableConcurrentReads();
+    ConcurrentStore::Snapshot snapshot() const;
 };
 
 #endif
@@ -1,65 +1,502 @@
 #include "Analyzer.h"
+#include "Reductions.h"
+#include "ThreadPool.h"
+#include "Timestamp.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <map>
 
-float Analyzer::averageTemperature(const std::vector<Measurement>& data) {
-    if (data.empty()) return 0.0f;
-    float sum = 0.0f;
+namespace {
+
+Analyzer::FieldStats fromReduction(const Reductions::Result& r) {
+    Analyzer::FieldStats stats;
+    stats.count = r.count;
+    if (r.count == 0) return stats;
+    stats.mean = r.mean();
+    stats.m2 = r.m2;
+    stats.min = r.min;
+    stats.max = r.max;
+    return stats;
+}
+
+// 64 KiB of floats: a tile and its neighbours stay in L2 while reduced.
+// Tiles match Reductions' blocks, so tiling changes nothing in the result.
+const size_t TILE_VALUES = Reductions::BLOCK_VALUES;
+
+static_assert(ConcurrentStore::CHUNK_ROWS == TILE_VALUES, "snapshot chunks are reduced as tiles");
+
+// Fixed tile order keeps the rounding independent of scheduling
+Reductions::Result combineTiles(const std::vector<Reductions::Result>& partials) {
+    Reductions::Combiner combined;
+    for (const Reductions::Result& partial : partials) {
+        combined.add(partial);
+    }
+    return combined.value();
+}
+
+// One result per tile, in tile order
+template <typename Part, typename ReduceTile>
+std::vector<Part> reduceTiles(std::span<const float> values, ReduceTile reduce) {
+    size_t tiles = (values.size() + TILE_VALUES - 1) / TILE_VALUES;
+    std::vector<Part> partials(tiles);
+    auto reduceTile = [&](size_t t) {
+        partials[t] = reduce(values.subspan(t * TILE_VALUES, std::min(TILE_VALUES, values.size() - t * TILE_VALUES)));
+    };
+    if (values.size() < Analyzer::PARALLEL_MIN_VALUES) {
+        for (size_t t = 0; t < tiles; t++) reduceTile(t);
+    } else {
+        ThreadPool::shared().parallelFor(tiles, reduceTile);
+    }
+    return partials;
+}
+
+Reductions::Result reduceWith(std::span<const float> values, Analyzer::Execution execution) {
+    if (execution == Analyzer::Execution::Serial) return Reductions::reduce(values);
+    return combineTiles(reduceTiles<Reductions::Result>(values, [](std::span<const float> tile) {
+        return Reductions::reduce(tile);
+    }));
+}
+
+// Min and max without the sums, for minimum() and maximum()
+Reductions::Extremes extremesWith(std::span<const float> values, Analyzer::Execution execution) {
+    if (execution == Analyzer::Execution::Serial) return Reductions::extremes(values);
+    std::vector<Reductions::Extremes> partials = reduceTiles<Reductions::Extremes>(
+        values, [](std::span<const float> tile) { return Reductions::extremes(tile); });
+    Reductions::Extremes combined;
+    for (const Reductions::Extremes& part : partials) {
+        combined.add(part);
+    }
+    return combined;
+}
+
+// Shared by the std::vector and TimeRange overloads
+typedef float (Measurement::*FieldGetter)() const;
+
+// NaN values are skipped, as in FieldStats::add; no values gives 0
+template <typename Rows>
+float averageOf(const Rows& data, FieldGetter get) {
+    Reductions::Accumulator sum;
+    size_t count = 0;
     for (size_t i = 0; i < data.size(); i++) {
-        sum += data[i].getTemperature();
+        float value = (data[i].*get)();
+        if (std::isnan(value)) continue;
+        sum.add(value);
+        count++;
     }
-    return sum / data.size();
+    return count > 0 ? static_cast<float>(sum.value() / count) : 0.0f;
 }
 
-float Analyzer::minTemperature(const std::vector<Measurement>& data) {
-    if (data.empty()) return 0.0f;
-    float min = data[0].getTemperature();
-    for (size_t i = 1; i < data.size(); i++) {
-        if (data[i].getTemperature() < min) {
-            min = data[i].getTemperature();
+template <typename Rows>
+float minimumOf(const Rows& data, FieldGetter get) {
+    bool found = false;
+    float min = 0.0f;
+    for (size_t i = 0; i < data.size(); i++) {
+        float value = (data[i].*get)();
+        if (!std::isnan(value) && (!found || value < min)) {
+            min = value;
+            found = true;
         }
     }
     return min;
 }
 
-float Analyzer::maxTemperature(const std::vector<Measurement>& data) {
-    if (data.empty()) return 0.0f;
-    float max = data[0].getTemperature();
-    for (size_t i = 1; i < data.size(); i++) {
-        if (data[i].getTemperature() > max) {
-            max = data[i].getTemperature();
+template <typename Rows>
+float maximumOf(const Rows& data, FieldGetter get) {
+    bool found = false;
+    float max = 0.0f;
+    for (size_t i = 0; i < data.size(); i++) {
+        float value = (data[i].*get)();
+        if (!std::isnan(value) && (!found || value > max)) {
+            max = value;
+            found = true;
         }
     }
     return max;
 }
 
-float Analyzer::averageHumidity(const std::vector<Measurement>& data) {
-    if (data.empty()) return 0.0f;
-    float sum = 0.0f;
-    for (size_t i = 0; i < data.size(); i++) {
-        sum += data[i].getHumidity();
+// Below this many rows per thread a group-by stays on the calling thread
+const size_t MIN_GROUP_ROWS_PER_THREAD = 64 * 1024;
+
+typedef std::map<int64_t, Analyzer::Summary> GroupMap;
+
+// Groups rows [first, last) of the columns
+void groupRows(const MeasurementColumns& columns, size_t first, size_t last, Analyzer::Bucket bucket,
+               GroupMap& groups) {
+    std::span<const int64_t> timestamps = columns.getTimestamps();
+    std::span<const float> temperatures = columns.getTemperatures();
+    std::span<const float> humidities = columns.getHumidities();
+    std::span<const float> windSpeeds = columns.getWindSpeeds();
+
+    // Neighbouring rows usually share a bucket, so the map is only searched
+    // again once a row leaves the hour (or day) the last key was found for
+    Analyzer::Summary* current = nullptr;
+    int64_t validFrom = 0, validTo = 0;
+    for (size_t i = first; i < last; i++) {
+        int64_t t = timestamps[i];
+        if (current == nullptr || t < validFrom || t >= validTo) {
+            current = &groups[Analyzer::bucketStart(t, bucket)];
+            if (bucket == Analyzer::Bucket::Hour) {
+                validFrom = Analyzer::bucketStart(t, bucket);
+                validTo = validFrom + Timestamp::MINUTES_PER_HOUR;
+            } else {
+                validFrom = Timestamp::dayNumber(t) * Timestamp::MINUTES_PER_DAY;
+                validTo = validFrom + Timestamp::MINUTES_PER_DAY;
+            }
+        }
+        current->add(temperatures[i], humidities[i], windSpeeds[i]);
     }
-    return sum / data.size();
 }
 
-float Analyzer::averageWindSpeed(const std::vector<Measurement>& data) {
-    if (data.empty()) return 0.0f;
-    float sum = 0.0f;
-    for (size_t i = 0; i < data.size(); i++) {
-        sum += data[i].getWindSpeed();
+template <typename Rows>
+Analyzer::Summary summarizeRows(const Rows& data) {
+    Analyzer::Summary summary;
+    for (const Measurement& m : data) {
+        summary.add(m);
     }
-    return sum / data.size();
+    return summary;
+}
+
+}
+
+float Analyzer::averageTemperature(const std::vector<Measurement>& data) {
+    return averageOf(data, &Measurement::getTemperature);
+}
+
+float Analyzer::minTemperature(const std::vector<Measurement>& data) {
+    return minimumOf(data, &Measurement::getTemperature);
+}
+
+float Analyzer::maxTemperature(const std::vector<Measurement>& data) {
+    return maximumOf(data, &Measurement::getTemperature);
+}
+
+float Analyzer::averageHumidity(const std::vector<Measurement>& data) {
+    return averageOf(data, &Measurement::getHumidity);
+}
+
+float Analyzer::averageWindSpeed(const std::vector<Measurement>& data) {
+    return averageOf(data, &Measurement::getWindSpeed);
+}
+
+float Analyzer::averageTemperature(const TimeRange& data) {
+    return averageOf(data, &Measurement::getTemperature);
+}
+
+float Analyzer::minTemperature(const TimeRange& data) {
+    return minimumOf(data, &Measurement::getTemperature);
+}
+
+float Analyzer::maxTemperature(const TimeRange& data) {
+    return maximumOf(data, &Measurement::getTemperature);
+}
+
+float Analyzer::averageHumidity(const TimeRange& data) {
+    return averageOf(data, &Measurement::getHumidity);
+}
+
+float Analyzer::averageWindSpeed(const TimeRange& data) {
+    return averageOf(data, &Measurement::getWindSpeed);
 }
 
 void Analyzer::displayStats(const std::vector<Measurement>& data) {
-    if (data.empty()) {
+    displayStats(summarize(data));
+}
+
+void Analyzer::displayStats(const Summary& summary) {
+    if (summary.count() == 0) {
         std::cout << "No data available for analysis." << std::endl;
         return;
     }
 
     std::cout << "=== Statistics ===" << std::endl;
-    std::cout << "Average Temperature: " << averageTemperature(data) << " C" << std::endl;
-    std::cout << "Min Temperature: " << minTemperature(data) << " C" << std::endl;
-    std::cout << "Max Temperature: " << maxTemperature(data) << " C" << std::endl;
-    std::cout << "Average Humidity: " << averageHumidity(data) << " %" << std::endl;
-    std::cout << "Average Wind Speed: " << averageWindSpeed(data) << " km/h" << std::endl;
+    if (summary.temperature.count > 0) {
+        std::cout << "Average Temperature: " << static_cast<float>(summary.temperature.mean) << " C" << std::endl;
+        std::cout << "Min Temperature: " << summary.temperature.min << " C" << std::endl;
+        std::cout << "Max Temperature: " << summary.temperature.max << " C" << std::endl;
+    }
+    if (summary.humidity.count > 0) {
+        std::cout << "Average Humidity: " << static_cast<float>(summary.humidity.mean) << " %" << std::endl;
+    }
+    if (summary.windSpeed.count > 0) {
+        std::cout << "Average Wind Speed: " << static_cast<float>(summary.windSpeed.mean) << " km/h" << std::endl;
+    }
+}
+
+void Analyzer::displayPercentiles(const MeasurementColumns& columns) {
+    if (columns.empty()) return;
+
+    Percentiles temperature = percentiles(columns.getTemperatures());
+    Percentiles windSpeed = percentiles(columns.getWindSpeeds());
+    std::cout << "Temperature p50/p95/p99: " << temperature.p50 << " / " << temperature.p95 << " / "
+              << temperature.p99 << " C" << std::endl;
+    std::cout << "Wind Speed p50/p95/p99: " << windSpeed.p50 << " / " << windSpeed.p95 << " / "
+              << windSpeed.p99 << " km/h" << std::endl;
+}
+
+void Analyzer::FieldStats::add(float value) {
+    if (std::isnan(value)) return;
+
+    if (count == 0) {
+        min = value;
+        max = value;
+    } else {
+        if (value < min) min = value;
+        if (value > max) max = value;
+    }
+    count++;
+    double delta = value - mean;
+    mean += delta / count;
+    m2 += delta * (value - mean);
+}
+
+void Analyzer::FieldStats::merge(const FieldStats& other) {
+    if (other.count == 0) return;
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+    // Chan et al. pairwise combination of two Welford states
+    size_t total = count + other.count;
+    double delta = other.mean - mean;
+    mean += delta * other.count / total;
+    m2 += other.m2 + delta * delta * (static_cast<double>(count) * other.count / total);
+    if (other.min < min) min = other.min;
+    if (other.max > max) max = other.max;
+    count = total;
+}
+
+double Analyzer::FieldStats::variance() const {
+    return count > 0 ? m2 / count : 0.0;
+}
+
+void Analyzer::Summary::add(const Measurement& m) {
+    add(m.getTemperature(), m.getHumidity(), m.getWindSpeed());
+}
+
+void Analyzer::Summary::add(float t, float h, float w) {
+    temperature.add(t);
+    humidity.add(h);
+    windSpeed.add(w);
+}
+
+void Analyzer::Summary::merge(const Summary& other) {
+    temperature.merge(other.temperature);
+    humidity.merge(other.humidity);
+    windSpeed.merge(other.windSpeed);
+}
+
+size_t Analyzer::Summary::count() const {
+    return std::max({temperature.count, humidity.count, windSpeed.count});
+}
+
+Analyzer::Summary Analyzer::summarize(const std::vector<Measurement>& data) {
+    return summarizeRows(data);
+}
+
+Analyzer::Summary Analyzer::summarize(const TimeRange& data) {
+    return summarizeRows(data);
+}
+
+Analyzer::Summary Analyzer::summarize(const MeasurementColumns& columns) {
+    Summary summary;
+    summary.temperature = fromReduction(Reductions::reduce(columns.getTemperatures()));
+    summary.humidity = fromReduction(Reductions::reduce(columns.getHumidities()));
+    summary.windSpeed = fromReduction(Reductions::reduce(columns.getWindSpeeds()));
+    return summary;
+}
+
+Analyzer::Summary Analyzer::summarize(const MeasurementColumns& columns, Execution execution) {
+    Summary summary;
+    summary.temperature = fromReduction(reduceWith(columns.getTemperatures(), execution));
+    summary.humidity = fromReduction(reduceWith(columns.getHumidities(), execution));
+    summary.windSpeed = fromReduction(reduceWith(columns.getWindSpeeds(), execution));
+    return summary;
+}
+
+Analyzer::Summary Analyzer::summarize(const ConcurrentStore::Snapshot& snapshot) {
+    size_t chunks = snapshot.chunkCount();
+    std::vector<Reductions::Result> temperatures(chunks), humidities(chunks), windSpeeds(chunks);
+    auto reduceChunk = [&](size_t c) {
+        ConcurrentStore::ChunkView chunk = snapshot.chunk(c);
+        temperatures[c] = Reductions::reduce(chunk.temperatures);
+        humidities[c] = Reductions::reduce(chunk.humidities);
+        windSpeeds[c] = Reductions::reduce(chunk.windSpeeds);
+    };
+    if (snapshot.size() < PARALLEL_MIN_VALUES) {
+        for (size_t c = 0; c < chunks; c++) reduceChunk(c);
+    } else {
+        ThreadPool::shared().parallelFor(chunks, reduceChunk);
+    }
+
+    Summary summary;
+    summary.temperature = fromReduction(combineTiles(temperatures));
+    summary.humidity = fromReduction(combineTiles(humidities));
+    summary.windSpeed = fromReduction(combineTiles(windSpeeds));
+    return summary;
+}
+
+float Analyzer::average(std::span<const float> values, Execution execution) {
+    return static_cast<float>(reduceWith(values, execution).mean());
+}
+
+float Analyzer::minimum(std::span<const float> values, Execution execution) {
+    return extremesWith(values, execution).min;
+}
+
+float Analyzer::maximum(std::span<const float> values, Execution execution) {
+    return extremesWith(values, execution).max;
+}
+
+float Analyzer::average(std::span<const float> values) {
+    return static_cast<float>(Reductions::reduce(values).mean());
+}
+
+float Analyzer::minimum(std::span<const float> values) {
+    return Reductions::min(values);
+}
+
+float Analyzer::maximum(std::span<const float> values) {
+    return Reductions::max(values);
+}
+
+int64_t Analyzer::bucketStart(int64_t timestamp, Bucket bucket) {
+    switch (bucket) {
+        case Bucket::Hour:
+            return timestamp - Timestamp::minuteOfDay(timestamp) % Timestamp::MINUTES_PER_HOUR;
+        case Bucket::Day:
+            return Timestamp::dayNumber(timestamp) * Timestamp::MINUTES_PER_DAY;
+        case Bucket::Week:
+            return Timestamp::startOfWeek(timestamp);
+        default:
+            return Timestamp::startOfMonth(timestamp);
+    }
+}
+
+std::vector<Analyzer::Group> Analyzer::groupBy(const MeasurementColumns& columns, Bucket bucket) {
+    size_t rows = columns.size();
+    size_t threadCount = ThreadPool::shared().size() + 1;
+    threadCount = std::max<size_t>(1, std::min(threadCount, rows / MIN_GROUP_ROWS_PER_THREAD));
+
+    GroupMap groups;
+    if (threadCount == 1) {
+        groupRows(columns, 0, rows, bucket, groups);
+    } else {
+        std::vector<GroupMap> partials(threadCount);
+        ThreadPool::shared().parallelFor(threadCount, [&](size_t t) {
+            groupRows(columns, rows * t / threadCount, rows * (t + 1) / threadCount, bucket, partials[t]);
+        });
+        // Merging in chunk order keeps the result independent of thread timing
+        for (const GroupMap& partial : partials) {
+            for (const auto& entry : partial) {
+                groups[entry.first].merge(entry.second);
+            }
+        }
+    }
+
+    std::vector<Group> result;
+    result.reserve(groups.size());
+    for (const auto& entry : groups) {
+        result.push_back(Group{entry.first, entry.second});
+    }
+    return result;
+}
+
+std::vector<Analyzer::Group> Analyzer::groupBy(const TimeRange& data, Bucket bucket) {
+    // Already in time order, so each bucket is one contiguous run
+    std::vector<Group> result;
+    for (const Measurement& m : data) {
+        int64_t start = bucketStart(m.getTimestamp(), bucket);
+        if (result.empty() || result.back().start != start) {
+            result.push_back(Group{start, Summary()});
+        }
+        result.back().summary.add(m);
+    }
+    return result;
+}
+
+QuantileSketch Analyzer::sketch(std::span<const float> values) {
+    QuantileSketch result;
+    result.add(values);
+    return result;
+}
+
+Analyzer::Percentiles Analyzer::percentiles(const QuantileSketch& sketch) {
+    std::vector<float> q = sketch.quantiles({0.50, 0.95, 0.99});
+    Percentiles result;
+    result.p50 = q[0];
+    result.p95 = q[1];
+    result.p99 = q[2];
+    return result;
+}
+
+Analyzer::Percentiles Analyzer::percentiles(std::span<const float> values) {
+    return percentiles(sketch(values));
+}
+
+Analyzer::RollingColumns Analyzer::rolling(std::span<const int64_t> timestamps, std::span<const float> values,
+                                           int64_t windowMinutes) {
+    size_t n = std::min(timestamps.size(), values.size());
+    RollingColumns out;
+    out.mean.resize(n);
+    out.min.resize(n);
+    out.max.resize(n);
+    // The narrowest window still holds the sample itself
+    windowMinutes = std::max<int64_t>(windowMinutes, 1);
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+
+    // Index queues: values in minQueue increase and in maxQueue decrease from
+    // the head, so the head is always the window's extreme. Indices only ever
+    // grow, so a vector plus a head offset serves as the deque. NaN samples
+    // never enter the queues or the sum.
+    std::vector<size_t> minQueue, maxQueue;
+    minQueue.reserve(n);
+    maxQueue.reserve(n);
+    size_t minHead = 0, maxHead = 0;
+    size_t windowStart = 0;
+    size_t valid = 0;
+    Reductions::Accumulator sum;
+
+    for (size_t i = 0; i < n; i++) {
+        float v = values[i];
+        if (!std::isnan(v)) {
+            sum.add(v);
+            valid++;
+            while (minQueue.size() > minHead && values[minQueue.back()] >= v) minQueue.pop_back();
+            minQueue.push_back(i);
+            while (maxQueue.size() > maxHead && values[maxQueue.back()] <= v) maxQueue.pop_back();
+            maxQueue.push_back(i);
+        }
+
+        while (windowStart < i && timestamps[windowStart] <= timestamps[i] - windowMinutes) {
+            if (!std::isnan(values[windowStart])) {
+                sum.add(-values[windowStart]);
+                valid--;
+            }
+            windowStart++;
+        }
+        while (minHead < minQueue.size() && minQueue[minHead] < windowStart) minHead++;
+        while (maxHead < maxQueue.size() && maxQueue[maxHead] < windowStart) maxHead++;
+
+        if (valid == 0) {
+            out.mean[i] = out.min[i] = out.max[i] = nan;
+            continue;
+        }
+        out.mean[i] = static_cast<float>(sum.value() / valid);
+        out.min[i] = values[minQueue[minHead]];
+        out.max[i] = values[maxQueue[maxHead]];
+    }
+    return out;
+}
+
+Analyzer::RollingColumns Analyzer::rolling(const TimeRange& series, float (Measurement::*field)() const,
+                                           int64_t windowMinutes) {
+    std::vector<int64_t> timestamps(series.size());
+    std::vector<float> values(series.size());
+    for (size_t i = 0; i < series.size(); i++) {
+        timestamps[i] = series[i].getTimestamp();
+        values[i] = (series[i].*field)();
+    }
+    return rolling(timestamps, values, windowMinutes);
 }
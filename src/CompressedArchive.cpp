@@ -0,0 +1,667 @@
+#include "CompressedArchive.h"
+#include "Crc32.h"
+#include "FileSync.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+static_assert(std::endian::native == std::endian::little, "archive headers are stored little-endian");
+
+namespace {
+
+const char MAGIC[8] = {'\x89', 'W', 'S', 'A', 'R', 'C', '\r', '\n'};
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t blockRows;
+    uint64_t rowCount;
+    uint64_t indexOffset;   // version 2 on; version 1 headers end before it
+};
+
+const size_t VERSION_1_HEADER_BYTES = offsetof(FileHeader, indexOffset);
+
+struct BlockFrame {
+    uint32_t rows;
+    uint32_t bytes;
+    uint32_t crc;
+    uint32_t reserved;
+};
+
+// Precedes the BlockIndex::Entry array at FileHeader::indexOffset
+struct IndexHeader {
+    uint32_t blockCount;
+    uint32_t crc;       // of the entries
+};
+
+static_assert(sizeof(CompressedArchive::BlockIndex::Entry) == 16, "index entries are stored as-is");
+
+// Byte lengths of the five field streams, at the start of every payload
+struct StreamSizes {
+    uint32_t bytes[5];
+};
+
+const int STREAM_COUNT = 5;
+
+// MSB-first bit packing
+class BitWriter {
+private:
+    std::vector<uint8_t>& out;
+    uint64_t buffer = 0;
+    int used = 0;
+
+    void emit(uint64_t word, int bytes) {
+        for (int i = 0; i < bytes; i++) {
+            out.push_back(static_cast<uint8_t>(word >> (56 - 8 * i)));
+        }
+    }
+
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : out(out) {}
+
+    // count is 1..64
+    void write(uint64_t value, int count) {
+        if (count > 32) {
+            write(value >> 32, count - 32);
+            count = 32;
+        }
+        value &= (uint64_t(1) << count) - 1;
+        int space = 64 - used;
+        if (count < space) {
+            buffer |= value << (space - count);
+            used += count;
+            return;
+        }
+        // Fill the word, emit it and start the next one with the remainder
+        int rest = count - space;
+        buffer |= value >> rest;
+        emit(buffer, 8);
+        buffer = rest > 0 ? value << (64 - rest) : 0;
+        used = rest;
+    }
+
+    void finish() {
+        emit(buffer, (used + 7) / 8);
+        buffer = 0;
+        used = 0;
+    }
+};
+
+class BitReader {
+private:
+    const uint8_t* p;
+    const uint8_t* end;
+    uint64_t window = 0;
+    int available = 0;
+    uint64_t bitsLeft;
+    bool overrun = false;
+
+    void refill() {
+        if (end - p >= 8) {
+            uint64_t word;
+            std::memcpy(&word, p, 8);
+            word = __builtin_bswap64(word);
+            int take = (64 - available) / 8;
+            window |= (word >> (64 - 8 * take)) << (64 - 8 * take - available);
+            p += take;
+            available += 8 * take;
+            return;
+        }
+        // Past the end the stream reads as zeros; bitsLeft catches real overruns
+        while (available <= 56) {
+            uint64_t byte = p < end ? *p++ : 0;
+            window |= byte << (56 - available);
+            available += 8;
+        }
+    }
+
+public:
+    BitReader(const uint8_t* begin, const uint8_t* end) : p(begin), end(end), bitsLeft(8 * uint64_t(end - begin)) {}
+
+    // count is 1..32
+    uint32_t read(int count) {
+        if (available < count) refill();
+        if (static_cast<uint64_t>(count) > bitsLeft) {
+            overrun = true;
+            bitsLeft = count;
+        }
+        bitsLeft -= count;
+        uint32_t value = static_cast<uint32_t>(window >> (64 - count));
+        window <<= count;
+        available -= count;
+        return value;
+    }
+
+    uint64_t read64() {
+        uint64_t high = read(32);
+        return high << 32 | read(32);
+    }
+
+    bool bit() { return read(1) != 0; }
+    bool failed() const { return overrun; }
+};
+
+uint64_t zigzag(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+int64_t unzigzag(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+// Delta-of-delta buckets: prefix bits, then the zigzagged value in width bits
+struct DodBucket {
+    uint32_t prefix;
+    int prefixBits;
+    int width;
+};
+
+const DodBucket DOD_BUCKETS[] = {
+    {0b10, 2, 7},
+    {0b110, 3, 9},
+    {0b1110, 4, 12},
+    {0b11110, 5, 32},
+};
+
+void encodeTimestamps(std::span<const int64_t> values, std::vector<uint8_t>& out) {
+    BitWriter bits(out);
+    int64_t previous = 0, previousDelta = 0;
+    for (size_t i = 0; i < values.size(); i++) {
+        if (i == 0) {
+            bits.write(static_cast<uint64_t>(values[0]), 64);
+            previous = values[0];
+            continue;
+        }
+        int64_t delta = values[i] - previous;
+        uint64_t dod = zigzag(delta - previousDelta);
+        previous = values[i];
+        previousDelta = delta;
+
+        if (dod == 0) {
+            bits.write(0, 1);
+            continue;
+        }
+        bool written = false;
+        for (const DodBucket& bucket : DOD_BUCKETS) {
+            if (dod < (uint64_t(1) << bucket.width)) {
+                bits.write(bucket.prefix, bucket.prefixBits);
+                bits.write(dod, bucket.width);
+                written = true;
+                break;
+            }
+        }
+        if (!written) {
+            bits.write(0b11111, 5);
+            bits.write(dod, 64);
+        }
+    }
+    bits.finish();
+}
+
+void decodeTimestamps(BitReader& bits, size_t rows, int64_t* out) {
+    int64_t previous = 0, previousDelta = 0;
+    for (size_t i = 0; i < rows; i++) {
+        if (i == 0) {
+            previous = static_cast<int64_t>(bits.read64());
+            out[0] = previous;
+            continue;
+        }
+        uint64_t dod = 0;
+        if (bits.bit()) {
+            int ones = 1;
+            while (ones < 5 && bits.bit()) ones++;
+            dod = ones == 5 ? bits.read64() : bits.read(DOD_BUCKETS[ones - 1].width);
+        }
+        previousDelta += unzigzag(dod);
+        previous += previousDelta;
+        out[i] = previous;
+    }
+}
+
+void encodeIds(std::span<const int> values, std::vector<uint8_t>& out) {
+    int64_t previous = 0;
+    for (int id : values) {
+        uint64_t v = zigzag(static_cast<int64_t>(id) - previous);
+        previous = id;
+        while (v >= 0x80) {
+            out.push_back(static_cast<uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(v));
+    }
+}
+
+bool decodeIds(const uint8_t* p, const uint8_t* end, size_t rows, int* out) {
+    int64_t previous = 0;
+    for (size_t i = 0; i < rows; i++) {
+        uint64_t v = 0;
+        int shift = 0;
+        while (true) {
+            if (p == end || shift > 63) return false;
+            uint8_t byte = *p++;
+            v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
+            shift += 7;
+        }
+        previous += unzigzag(v);
+        out[i] = static_cast<int>(previous);
+    }
+    return p == end;
+}
+
+// Gorilla XOR coding on the 32-bit patterns: '0' repeats the previous
+// value; '10' reuses the previous leading/trailing zero window; '11' sends
+// a new window (5 bits leading zeros, 5 bits length - 1) and the bits
+void encodeFloats(std::span<const float> values, std::vector<uint8_t>& out) {
+    BitWriter bits(out);
+    uint32_t previous = 0;
+    int leading = -1, trailing = 0;
+    for (size_t i = 0; i < values.size(); i++) {
+        uint32_t v = std::bit_cast<uint32_t>(values[i]);
+        if (i == 0) {
+            bits.write(v, 32);
+            previous = v;
+            continue;
+        }
+        uint32_t x = v ^ previous;
+        previous = v;
+        if (x == 0) {
+            bits.write(0, 1);
+            continue;
+        }
+        int lz = std::countl_zero(x);
+        int tz = std::countr_zero(x);
+        if (leading >= 0 && lz >= leading && tz >= trailing) {
+            bits.write(0b10, 2);
+            bits.write(x >> trailing, 32 - leading - trailing);
+        } else {
+            int length = 32 - lz - tz;
+            bits.write(0b11, 2);
+            bits.write(lz, 5);
+            bits.write(length - 1, 5);
+            bits.write(x >> tz, length);
+            leading = lz;
+            trailing = tz;
+        }
+    }
+    bits.finish();
+}
+
+void decodeFloats(BitReader& bits, size_t rows, float* out) {
+    uint32_t previous = 0;
+    int leading = 0, trailing = 0;
+    for (size_t i = 0; i < rows; i++) {
+        if (i == 0) {
+            previous = bits.read(32);
+        } else if (bits.bit()) {
+            if (bits.bit()) {
+                leading = bits.read(5);
+                int length = bits.read(5) + 1;
+                trailing = 32 - leading - length;
+                if (trailing < 0) trailing = 0;
+            }
+            int length = 32 - leading - trailing;
+            previous ^= bits.read(length) << trailing;
+        }
+        out[i] = std::bit_cast<float>(previous);
+    }
+}
+
+IndexHeader makeIndexHeader(const std::vector<CompressedArchive::BlockIndex::Entry>& blocks) {
+    IndexHeader header;
+    header.blockCount = static_cast<uint32_t>(blocks.size());
+    header.crc = Crc32::compute(blocks.data(), blocks.size() * sizeof(blocks[0]));
+    return header;
+}
+
+size_t indexBytes(size_t blockCount) {
+    return sizeof(IndexHeader) + blockCount * sizeof(CompressedArchive::BlockIndex::Entry);
+}
+
+}
+
+void CompressedArchive::encodeBlock(std::span<const int64_t> timestamps, std::span<const int> ids,
+                                    std::span<const float> temperatures, std::span<const float> humidities,
+                                    std::span<const float> windSpeeds, std::vector<uint8_t>& out) {
+    size_t headerAt = out.size();
+    out.resize(headerAt + sizeof(StreamSizes));
+    StreamSizes sizes;
+
+    size_t start = out.size();
+    encodeTimestamps(timestamps, out);
+    sizes.bytes[0] = static_cast<uint32_t>(out.size() - start);
+    start = out.size();
+    encodeIds(ids, out);
+    sizes.bytes[1] = static_cast<uint32_t>(out.size() - start);
+    std::span<const float> floats[3] = {temperatures, humidities, windSpeeds};
+    for (int f = 0; f < 3; f++) {
+        start = out.size();
+        encodeFloats(floats[f], out);
+        sizes.bytes[2 + f] = static_cast<uint32_t>(out.size() - start);
+    }
+    std::memcpy(out.data() + headerAt, &sizes, sizeof(sizes));
+}
+
+bool CompressedArchive::decodeBlock(const uint8_t* begin, const uint8_t* end, size_t rows, int64_t* timestamps,
+                                    int* ids, float* temperatures, float* humidities, float* windSpeeds) {
+    if (static_cast<size_t>(end - begin) < sizeof(StreamSizes)) return false;
+    StreamSizes sizes;
+    std::memcpy(&sizes, begin, sizeof(sizes));
+
+    const uint8_t* streams[STREAM_COUNT + 1];
+    streams[0] = begin + sizeof(StreamSizes);
+    for (int s = 0; s < STREAM_COUNT; s++) {
+        if (sizes.bytes[s] > static_cast<size_t>(end - streams[s])) return false;
+        streams[s + 1] = streams[s] + sizes.bytes[s];
+    }
+    if (streams[STREAM_COUNT] != end) return false;
+
+    BitReader timeBits(streams[0], streams[1]);
+    decodeTimestamps(timeBits, rows, timestamps);
+    if (timeBits.failed() || !decodeIds(streams[1], streams[2], rows, ids)) return false;
+
+    float* floats[3] = {temperatures, humidities, windSpeeds};
+    for (int f = 0; f < 3; f++) {
+        BitReader bits(streams[2 + f], streams[3 + f]);
+        decodeFloats(bits, rows, floats[f]);
+        if (bits.failed()) return false;
+    }
+    return true;
+}
+
+bool CompressedArchive::isArchive(const char* begin, const char* end) {
+    return static_cast<size_t>(end - begin) >= sizeof(MAGIC) && std::memcmp(begin, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+bool CompressedArchive::isArchiveFile(const std::string& filename) {
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    char magic[sizeof(MAGIC)];
+    if (!file.read(magic, sizeof(magic))) {
+        return false;
+    }
+    return isArchive(magic, magic + sizeof(magic));
+}
+
+CompressedArchive::Writer::~Writer() {
+    if (file.is_open()) {
+        file.close();
+        std::remove((filename + ".tmp").c_str());
+    }
+}
+
+bool CompressedArchive::Writer::open(const std::string& name) {
+    filename = name;
+    rows = 0;
+    failed = false;
+    pending.clear();
+    index = BlockIndex();
+    file.open((filename + ".tmp").c_str(), std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    // The row count and index offset are patched in by close()
+    FileHeader header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.blockRows = BLOCK_ROWS;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return true;
+}
+
+void CompressedArchive::Writer::append(const Measurement& m) {
+    pending.append(m);
+    if (pending.size() == BLOCK_ROWS) {
+        flushBlock();
+    }
+}
+
+void CompressedArchive::Writer::flushBlock() {
+    if (pending.empty()) return;
+
+    encoded.clear();
+    encodeBlock(pending.getTimestamps(), pending.getIds(), pending.getTemperatures(), pending.getHumidities(),
+                pending.getWindSpeeds(), encoded);
+    BlockFrame frame = {};
+    frame.rows = static_cast<uint32_t>(pending.size());
+    frame.bytes = static_cast<uint32_t>(encoded.size());
+    frame.crc = Crc32::compute(encoded.data(), encoded.size());
+    index.blocks.push_back({static_cast<uint64_t>(file.tellp()), frame.rows, frame.bytes});
+    file.write(reinterpret_cast<const char*>(&frame), sizeof(frame));
+    file.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+    if (!file) failed = true;
+
+    rows += pending.size();
+    pending.clear();
+}
+
+bool CompressedArchive::Writer::close() {
+    if (!file.is_open()) {
+        return false;
+    }
+    flushBlock();
+    index.indexOffset = static_cast<uint64_t>(file.tellp());
+    IndexHeader indexHeader = makeIndexHeader(index.blocks);
+    file.write(reinterpret_cast<const char*>(&indexHeader), sizeof(indexHeader));
+    file.write(reinterpret_cast<const char*>(index.blocks.data()), index.blocks.size() * sizeof(index.blocks[0]));
+    index.fileBytes = index.indexOffset + indexBytes(index.blocks.size());
+
+    file.seekp(offsetof(FileHeader, rowCount));
+    file.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+    file.write(reinterpret_cast<const char*>(&index.indexOffset), sizeof(index.indexOffset));
+    file.close();
+
+    std::string temporary = filename + ".tmp";
+    if (failed || !file) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    // A failed replace keeps both the old archive and the new one's .tmp
+    return FileSync::replace(temporary, filename);
+}
+
+const CompressedArchive::BlockIndex& CompressedArchive::Writer::getIndex() const {
+    return index;
+}
+
+bool CompressedArchive::save(const std::string& filename, const MeasurementColumns& columns, BlockIndex* index) {
+    Writer writer;
+    if (!writer.open(filename)) {
+        return false;
+    }
+    for (size_t i = 0; i < columns.size(); i++) {
+        writer.append(columns.row(i));
+    }
+    if (!writer.close()) {
+        return false;
+    }
+    if (index != nullptr) {
+        *index = writer.getIndex();
+    }
+    return true;
+}
+
+bool CompressedArchive::load(const char* begin, const char* end, MeasurementColumns& columns, BlockIndex* index) {
+    size_t size = end - begin;
+    if (size < VERSION_1_HEADER_BYTES || !isArchive(begin, end)) {
+        return false;
+    }
+    FileHeader header = {};
+    std::memcpy(&header, begin, VERSION_1_HEADER_BYTES);
+    if (header.version == 0 || header.version > VERSION) {
+        return false;
+    }
+
+    // Version 1 files are a plain run of blocks; later ones list them in the index
+    BlockIndex found;
+    if (header.version == 1) {
+        size_t offset = VERSION_1_HEADER_BYTES;
+        while (offset < size) {
+            BlockFrame frame;
+            if (size - offset < sizeof(BlockFrame)) return false;
+            std::memcpy(&frame, begin + offset, sizeof(BlockFrame));
+            found.blocks.push_back({offset, frame.rows, frame.bytes});
+            offset += sizeof(BlockFrame);
+            if (frame.bytes > size - offset) return false;
+            offset += frame.bytes;
+        }
+    } else {
+        if (size < sizeof(FileHeader)) return false;
+        std::memcpy(&header, begin, sizeof(FileHeader));
+        if (header.indexOffset < sizeof(FileHeader) || header.indexOffset > size ||
+            size - header.indexOffset < sizeof(IndexHeader)) {
+            return false;
+        }
+        IndexHeader indexHeader;
+        std::memcpy(&indexHeader, begin + header.indexOffset, sizeof(IndexHeader));
+        size_t entriesAt = header.indexOffset + sizeof(IndexHeader);
+        if (indexHeader.blockCount > (size - entriesAt) / sizeof(BlockIndex::Entry)) return false;
+        found.blocks.resize(indexHeader.blockCount);
+        std::memcpy(found.blocks.data(), begin + entriesAt, found.blocks.size() * sizeof(BlockIndex::Entry));
+        if (makeIndexHeader(found.blocks).crc != indexHeader.crc) return false;
+        found.indexOffset = header.indexOffset;
+    }
+    found.fileBytes = size;
+
+    // Check every frame against its entry so each block knows where its rows go
+    struct Block {
+        const uint8_t* payload;
+        BlockFrame frame;
+        uint64_t firstRow;
+    };
+    std::vector<Block> blocks;
+    blocks.reserve(found.blocks.size());
+    uint64_t rows = 0;
+    for (const BlockIndex::Entry& entry : found.blocks) {
+        Block block;
+        if (entry.offset > size || size - entry.offset < sizeof(BlockFrame)) return false;
+        std::memcpy(&block.frame, begin + entry.offset, sizeof(BlockFrame));
+        size_t payloadAt = entry.offset + sizeof(BlockFrame);
+        if (block.frame.rows == 0 || block.frame.rows != entry.rows || block.frame.bytes != entry.bytes ||
+            entry.bytes > size - payloadAt) {
+            return false;
+        }
+        block.payload = reinterpret_cast<const uint8_t*>(begin + payloadAt);
+        block.firstRow = rows;
+        blocks.push_back(block);
+        rows += block.frame.rows;
+    }
+    if (rows != header.rowCount) {
+        return false;
+    }
+
+    std::vector<int64_t> timestamps(rows);
+    std::vector<int> ids(rows);
+    std::vector<float> temperatures(rows), humidities(rows), windSpeeds(rows);
+    std::vector<char> valid(blocks.size(), 0);
+    ThreadPool::shared().parallelFor(blocks.size(), [&](size_t b) {
+        const Block& block = blocks[b];
+        const uint8_t* payloadEnd = block.payload + block.frame.bytes;
+        uint64_t r = block.firstRow;
+        valid[b] = Crc32::compute(block.payload, block.frame.bytes) == block.frame.crc &&
+                   decodeBlock(block.payload, payloadEnd, block.frame.rows, &timestamps[r], &ids[r],
+                               &temperatures[r], &humidities[r], &windSpeeds[r]);
+    });
+    for (char ok : valid) {
+        if (!ok) return false;
+    }
+
+    columns.assign(std::move(ids), std::move(temperatures), std::move(humidities), std::move(windSpeeds),
+                   std::move(timestamps));
+    if (index != nullptr) {
+        *index = std::move(found);
+    }
+    return true;
+}
+
+bool CompressedArchive::update(const std::string& filename, const MeasurementColumns& columns,
+                               const std::vector<bool>& dirty, BlockIndex& index) {
+    std::error_code error;
+    if (index.indexOffset == 0 || std::filesystem::file_size(filename, error) != index.fileBytes || error) {
+        return false;
+    }
+    FILE* file = std::fopen(filename.c_str(), "r+b");
+    if (file == nullptr) {
+        return false;
+    }
+    FileHeader header;
+    if (std::fread(&header, sizeof(header), 1, file) != 1 || !isArchive(header.magic, header.magic + sizeof(MAGIC)) ||
+        header.version != VERSION || header.blockRows != BLOCK_ROWS || header.indexOffset != index.indexOffset) {
+        std::fclose(file);
+        return false;
+    }
+
+    size_t rows = columns.size();
+    size_t blockCount = (rows + BLOCK_ROWS - 1) / BLOCK_ROWS;
+    std::vector<BlockIndex::Entry> blocks(blockCount);
+    std::vector<size_t> rewrite;
+    for (size_t b = 0; b < blockCount; b++) {
+        uint32_t blockRows = static_cast<uint32_t>(std::min(BLOCK_ROWS, rows - b * BLOCK_ROWS));
+        if (b < index.blocks.size() && index.blocks[b].rows == blockRows && !(b < dirty.size() && dirty[b])) {
+            blocks[b] = index.blocks[b];
+        } else {
+            blocks[b].rows = blockRows;
+            rewrite.push_back(b);
+        }
+    }
+
+    if (rewrite.empty() && blockCount == index.blocks.size()) {
+        std::fclose(file);
+        return true;
+    }
+
+    std::vector<std::vector<uint8_t>> payloads(rewrite.size());
+    ThreadPool::shared().parallelFor(rewrite.size(), [&](size_t i) {
+        size_t first = rewrite[i] * BLOCK_ROWS;
+        size_t count = blocks[rewrite[i]].rows;
+        encodeBlock(columns.getTimestamps().subspan(first, count), columns.getIds().subspan(first, count),
+                    columns.getTemperatures().subspan(first, count), columns.getHumidities().subspan(first, count),
+                    columns.getWindSpeeds().subspan(first, count), payloads[i]);
+    });
+
+    uint64_t offset = index.fileBytes;
+    for (size_t i = 0; i < rewrite.size(); i++) {
+        BlockIndex::Entry& entry = blocks[rewrite[i]];
+        entry.offset = offset;
+        entry.bytes = static_cast<uint32_t>(payloads[i].size());
+        offset += sizeof(BlockFrame) + entry.bytes;
+    }
+    uint64_t indexOffset = offset;
+    uint64_t fileBytes = indexOffset + indexBytes(blockCount);
+
+    uint64_t liveBytes = sizeof(FileHeader) + indexBytes(blockCount);
+    for (const BlockIndex::Entry& entry : blocks) {
+        liveBytes += sizeof(BlockFrame) + entry.bytes;
+    }
+    if (fileBytes > 2 * liveBytes) {
+        std::fclose(file);
+        return save(filename, columns, &index);
+    }
+
+    // Everything new goes past the end of the file and is synced before the
+    // header points at it
+    bool ok = std::fseek(file, 0, SEEK_END) == 0;
+    for (size_t i = 0; ok && i < rewrite.size(); i++) {
+        BlockFrame frame = {};
+        frame.rows = blocks[rewrite[i]].rows;
+        frame.bytes = blocks[rewrite[i]].bytes;
+        frame.crc = Crc32::compute(payloads[i].data(), payloads[i].size());
+        ok = std::fwrite(&frame, sizeof(frame), 1, file) == 1 &&
+             std::fwrite(payloads[i].data(), 1, payloads[i].size(), file) == payloads[i].size();
+    }
+    IndexHeader indexHeader = makeIndexHeader(blocks);
+    ok = ok && std::fwrite(&indexHeader, sizeof(indexHeader), 1, file) == 1 &&
+         std::fwrite(blocks.data(), sizeof(blocks[0]), blocks.size(), file) == blocks.size() && FileSync::flush(file);
+
+    header.rowCount = rows;
+    header.indexOffset = indexOffset;
+    ok = ok && std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+         FileSync::flush(file);
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        return false;
+    }
+
+    index.blocks = std::move(blocks);
+    index.indexOffset = indexOffset;
+    index.fileBytes = fileBytes;
+    return true;
+}
@@ -0,0 +1,137 @@
+#include "ConcurrentStore.h"
+#include <algorithm>
+
+ConcurrentStore::Snapshot::Snapshot(std::shared_ptr<const Directory> directory, size_t rows)
+    : directory(std::move(directory)), rows(rows) {}
+
+size_t ConcurrentStore::Snapshot::size() const {
+    return rows;
+}
+
+bool ConcurrentStore::Snapshot::empty() const {
+    return rows == 0;
+}
+
+Measurement ConcurrentStore::Snapshot::row(size_t slot) const {
+    const Chunk& chunk = *directory->chunks[slot / CHUNK_ROWS];
+    size_t i = slot % CHUNK_ROWS;
+    return Measurement(chunk.ids[i], chunk.temperatures[i], chunk.humidities[i], chunk.windSpeeds[i],
+                       chunk.timestamps[i]);
+}
+
+size_t ConcurrentStore::Snapshot::chunkCount() const {
+    return (rows + CHUNK_ROWS - 1) / CHUNK_ROWS;
+}
+
+ConcurrentStore::ChunkView ConcurrentStore::Snapshot::chunk(size_t c) const {
+    const Chunk& chunk = *directory->chunks[c];
+    size_t count = std::min(CHUNK_ROWS, rows - c * CHUNK_ROWS);
+    return {std::span<const int64_t>(chunk.timestamps, count), std::span<const int>(chunk.ids, count),
+            std::span<const float>(chunk.temperatures, count), std::span<const float>(chunk.humidities, count),
+            std::span<const float>(chunk.windSpeeds, count)};
+}
+
+ConcurrentStore::ConcurrentStore() : current(std::make_shared<Directory>()), published(current) {}
+
+void ConcurrentStore::publish(std::shared_ptr<Directory> directory) {
+    current = directory;
+    // The old directory is released outside the lock, in case this was its last reference
+    std::lock_guard<std::mutex> lock(publishMutex);
+    published.swap(directory);
+}
+
+std::shared_ptr<ConcurrentStore::Chunk> ConcurrentStore::copyChunk(const Chunk& chunk) {
+    return std::shared_ptr<Chunk>(new Chunk(chunk));
+}
+
+void ConcurrentStore::writeRow(Chunk& chunk, size_t index, const Measurement& m) {
+    chunk.timestamps[index] = m.getTimestamp();
+    chunk.ids[index] = m.getId();
+    chunk.temperatures[index] = m.getTemperature();
+    chunk.humidities[index] = m.getHumidity();
+    chunk.windSpeeds[index] = m.getWindSpeed();
+}
+
+void ConcurrentStore::append(const Measurement& m) {
+    append(std::span<const Measurement>(&m, 1));
+}
+
+void ConcurrentStore::append(std::span<const Measurement> rows) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    size_t count = current->rows.load(std::memory_order_relaxed);
+    size_t next = 0;
+    while (next < rows.size()) {
+        if (count == current->chunks.size() * CHUNK_ROWS) {
+            // A full directory is replaced, never grown in place: snapshots hold on to it
+            auto grown = std::make_shared<Directory>();
+            grown->chunks = current->chunks;
+            grown->chunks.push_back(std::shared_ptr<Chunk>(new Chunk));
+            grown->rows.store(count, std::memory_order_relaxed);
+            publish(std::move(grown));
+        }
+        Chunk& chunk = *current->chunks[count / CHUNK_ROWS];
+        size_t fill = std::min(rows.size() - next, CHUNK_ROWS - count % CHUNK_ROWS);
+        for (size_t i = 0; i < fill; i++) {
+            writeRow(chunk, count % CHUNK_ROWS + i, rows[next + i]);
+        }
+        next += fill;
+        count += fill;
+        current->rows.store(count, std::memory_order_release);
+    }
+}
+
+void ConcurrentStore::erase(size_t slot) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    size_t count = current->rows.load(std::memory_order_relaxed);
+    if (slot >= count) {
+        return;
+    }
+    size_t rows = count - 1;
+    Snapshot before(current, count);
+
+    // Chunks before slot's are shared with older snapshots; the rest are
+    // copies with their rows moved down one
+    auto next = std::make_shared<Directory>();
+    size_t first = slot / CHUNK_ROWS;
+    size_t chunks = (rows + CHUNK_ROWS - 1) / CHUNK_ROWS;
+    next->chunks.assign(current->chunks.begin(), current->chunks.begin() + std::min(first, chunks));
+    for (size_t c = first; c < chunks; c++) {
+        std::shared_ptr<Chunk> chunk = copyChunk(*current->chunks[c]);
+        size_t end = std::min((c + 1) * CHUNK_ROWS, rows);
+        for (size_t i = std::max(c * CHUNK_ROWS, slot); i < end; i++) {
+            writeRow(*chunk, i % CHUNK_ROWS, before.row(i + 1));
+        }
+        next->chunks.push_back(std::move(chunk));
+    }
+    next->rows.store(rows, std::memory_order_relaxed);
+    publish(std::move(next));
+}
+
+void ConcurrentStore::assign(std::span<const Measurement> rows) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    auto next = std::make_shared<Directory>();
+    for (size_t first = 0; first < rows.size(); first += CHUNK_ROWS) {
+        auto chunk = std::shared_ptr<Chunk>(new Chunk);
+        size_t fill = std::min(CHUNK_ROWS, rows.size() - first);
+        for (size_t i = 0; i < fill; i++) {
+            writeRow(*chunk, i, rows[first + i]);
+        }
+        next->chunks.push_back(std::move(chunk));
+    }
+    next->rows.store(rows.size(), std::memory_order_relaxed);
+    publish(std::move(next));
+}
+
+ConcurrentStore::Snapshot ConcurrentStore::snapshot() const {
+    std::shared_ptr<Directory> directory;
+    {
+        std::lock_guard<std::mutex> lock(publishMutex);
+        directory = published;
+    }
+    size_t rows = directory->rows.load(std::memory_order_acquire);
+    return Snapshot(std::move(directory), rows);
+}
+
+size_t ConcurrentStore::size() const {
+    return snapshot().size();
+}
@@ -0,0 +1,51 @@
+#include "Crc32.h"
+
+namespace {
+
+// Slicing-by-4 tables: table[0] is the classic byte table, table[k] folds
+// a byte that sits k positions further from the end of a 4-byte word
+struct Tables {
+    uint32_t table[4][256];
+
+    Tables() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int bit = 0; bit < 8; bit++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; i++) {
+            for (int k = 1; k < 4; k++) {
+                table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+const Tables& tables() {
+    static const Tables instance;
+    return instance;
+}
+
+}
+
+uint32_t Crc32::compute(const void* data, size_t size, uint32_t crc) {
+    const uint32_t (*t)[256] = tables().table;
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+
+    while (size >= 4) {
+        crc ^= static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+               static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+        crc = t[3][crc & 0xFF] ^ t[2][(crc >> 8) & 0xFF] ^ t[1][(crc >> 16) & 0xFF] ^ t[0][crc >> 24];
+        p += 4;
+        size -= 4;
+    }
+    while (size > 0) {
+        crc = t[0][(crc ^ *p) & 0xFF] ^ (crc >> 8);
+        p++;
+        size--;
+    }
+    return ~crc;
+}
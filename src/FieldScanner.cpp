@@ -0,0 +1,101 @@
+#include "FieldScanner.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FIELDSCANNER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+void scanScalar(const char* begin, const char* p, const char* end, std::vector<uint32_t>& index) {
+    for (; p < end; p++) {
+        if (*p == ';' || *p == '\n') {
+            index.push_back(static_cast<uint32_t>(p - begin));
+        }
+    }
+}
+
+#ifdef FIELDSCANNER_X86
+
+void pushMask(uint32_t mask, uint32_t base, std::vector<uint32_t>& index) {
+    while (mask != 0) {
+        index.push_back(base + __builtin_ctz(mask));
+        mask &= mask - 1;
+    }
+}
+
+__attribute__((target("sse2")))
+void scanSSE2(const char* begin, const char* end, std::vector<uint32_t>& index) {
+    const __m128i semicolon = _mm_set1_epi8(';');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const char* p = begin;
+    for (; end - p >= 16; p += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, semicolon), _mm_cmpeq_epi8(chunk, newline));
+        pushMask(static_cast<uint32_t>(_mm_movemask_epi8(hits)), static_cast<uint32_t>(p - begin), index);
+    }
+    scanScalar(begin, p, end, index);
+}
+
+__attribute__((target("avx2")))
+void scanAVX2(const char* begin, const char* end, std::vector<uint32_t>& index) {
+    const __m256i semicolon = _mm256_set1_epi8(';');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const char* p = begin;
+    for (; end - p >= 32; p += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, semicolon), _mm256_cmpeq_epi8(chunk, newline));
+        pushMask(static_cast<uint32_t>(_mm256_movemask_epi8(hits)), static_cast<uint32_t>(p - begin), index);
+    }
+    scanScalar(begin, p, end, index);
+}
+
+#endif
+
+FieldScanner::Kernel detectKernel() {
+#ifdef FIELDSCANNER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return FieldScanner::Kernel::AVX2;
+    if (__builtin_cpu_supports("sse2")) return FieldScanner::Kernel::SSE2;
+#endif
+    return FieldScanner::Kernel::Scalar;
+}
+
+}
+
+FieldScanner::Kernel FieldScanner::bestKernel() {
+    static const Kernel kernel = detectKernel();
+    return kernel;
+}
+
+const char* FieldScanner::kernelName(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::SSE2: return "SSE2";
+        case Kernel::AVX2: return "AVX2";
+        default: return "Scalar";
+    }
+}
+
+void FieldScanner::buildIndex(const char* begin, const char* end, std::vector<uint32_t>& index) {
+    buildIndex(begin, end, index, bestKernel());
+}
+
+void FieldScanner::buildIndex(const char* begin, const char* end, std::vector<uint32_t>& index, Kernel kernel) {
+    index.clear();
+    // Typical lines are ~32 bytes with 6 delimiters
+    index.reserve((end - begin) / 5);
+
+#ifdef FIELDSCANNER_X86
+    if (kernel == Kernel::AVX2 && bestKernel() == Kernel::AVX2) {
+        scanAVX2(begin, end, index);
+        return;
+    }
+    if (kernel != Kernel::Scalar && bestKernel() != Kernel::Scalar) {
+        scanSSE2(begin, end, index);
+        return;
+    }
+#else
+    (void)kernel;
+#endif
+    scanScalar(begin, begin, end, index);
+}
@@ -0,0 +1,59 @@
+#include "FileSync.h"
+#include <filesystem>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+bool FileSync::flush(FILE* file) {
+    if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool FileSync::syncFile(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "r+b");
+    if (file == nullptr) return false;
+    bool ok = flush(file);
+    return std::fclose(file) == 0 && ok;
+}
+
+bool FileSync::syncDirectory(const std::string& path) {
+#ifdef _WIN32
+    (void)path;
+    return true;
+#else
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) return false;
+    bool ok = fsync(fd) == 0;
+    return ::close(fd) == 0 && ok;
+#endif
+}
+
+bool FileSync::replace(const std::string& temporary, const std::string& target) {
+    if (!syncFile(temporary)) {
+        return false;
+    }
+#ifdef _WIN32
+    // Plain rename() refuses to replace an existing file on Windows
+    std::wstring from = std::filesystem::path(temporary).wstring();
+    std::wstring to = std::filesystem::path(target).wstring();
+    return MoveFileExW(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(temporary.c_str(), target.c_str()) == 0 && syncDirectory(target);
+#endif
+}
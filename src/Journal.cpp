@@ -0,0 +1,287 @@
+#include "Journal.h"
+#include "Crc32.h"
+#include "FileSync.h"
+#include "Snapshot.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+// crc | type | lsn | timestamp | id | temperature | humidity | wind speed
+const size_t RECORD_BYTES = 40;
+const size_t CRC_BYTES = 4;
+
+void encodeRecord(const Journal::Record& record, unsigned char* out) {
+    uint32_t type = static_cast<uint32_t>(record.type);
+    int64_t timestamp = record.measurement.getTimestamp();
+    int id = record.measurement.getId();
+    float values[3] = {record.measurement.getTemperature(), record.measurement.getHumidity(),
+                       record.measurement.getWindSpeed()};
+    std::memcpy(out + 4, &type, 4);
+    std::memcpy(out + 8, &record.lsn, 8);
+    std::memcpy(out + 16, &timestamp, 8);
+    std::memcpy(out + 24, &id, 4);
+    std::memcpy(out + 28, values, 12);
+    uint32_t crc = Crc32::compute(out + CRC_BYTES, RECORD_BYTES - CRC_BYTES);
+    std::memcpy(out, &crc, 4);
+}
+
+bool decodeRecord(const unsigned char* in, Journal::Record& record) {
+    uint32_t crc, type;
+    std::memcpy(&crc, in, 4);
+    if (Crc32::compute(in + CRC_BYTES, RECORD_BYTES - CRC_BYTES) != crc) {
+        return false;
+    }
+    std::memcpy(&type, in + 4, 4);
+    if (type != static_cast<uint32_t>(Journal::RecordType::Add) &&
+        type != static_cast<uint32_t>(Journal::RecordType::Delete)) {
+        return false;
+    }
+    int64_t timestamp;
+    int id;
+    float values[3];
+    std::memcpy(&record.lsn, in + 8, 8);
+    std::memcpy(&timestamp, in + 16, 8);
+    std::memcpy(&id, in + 24, 4);
+    std::memcpy(values, in + 28, 12);
+    record.type = static_cast<Journal::RecordType>(type);
+    record.measurement = Measurement(id, values[0], values[1], values[2], timestamp);
+    return true;
+}
+
+}
+
+Journal::~Journal() {
+    close();
+}
+
+std::string Journal::segmentName(uint64_t firstLsn) const {
+    // Zero-padded so the names sort in LSN order
+    char suffix[24];
+    std::snprintf(suffix, sizeof(suffix), "%016llu", static_cast<unsigned long long>(firstLsn));
+    return basePath + ".wal." + suffix;
+}
+
+std::vector<std::pair<uint64_t, std::string>> Journal::listSegments() const {
+    namespace fs = std::filesystem;
+    fs::path base(basePath);
+    fs::path directory = base.has_parent_path() ? base.parent_path() : fs::path(".");
+    std::string prefix = base.filename().string() + ".wal.";
+
+    std::vector<std::pair<uint64_t, std::string>> segments;
+    std::error_code error;
+    for (const fs::directory_entry& entry : fs::directory_iterator(directory, error)) {
+        std::string name = entry.path().filename().string();
+        if (name.size() != prefix.size() + 16 || name.compare(0, prefix.size(), prefix) != 0) continue;
+        uint64_t firstLsn = std::strtoull(name.c_str() + prefix.size(), nullptr, 10);
+        segments.emplace_back(firstLsn, entry.path().string());
+    }
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+bool Journal::open(const std::string& path, MeasurementColumns& snapshot, std::vector<Record>& tail) {
+    close();
+    basePath = path;
+    tail.clear();
+
+    uint64_t snapshotLsn = 0;
+    std::string snapshotFile = basePath + ".wsnap";
+    if (std::filesystem::exists(snapshotFile)) {
+        if (!Snapshot::load(snapshotFile, snapshot, &snapshotLsn)) {
+            return false;
+        }
+    } else {
+        snapshot.clear();
+    }
+
+    uint64_t lastSeen = snapshotLsn;
+    std::vector<std::pair<uint64_t, std::string>> segments = listSegments();
+    for (size_t s = 0; s < segments.size(); s++) {
+        std::ifstream file(segments[s].second.c_str(), std::ios::binary);
+        std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        size_t valid = 0;
+        Record record;
+        while (valid + RECORD_BYTES <= bytes.size() && decodeRecord(bytes.data() + valid, record)) {
+            if (record.lsn > snapshotLsn) {
+                tail.push_back(record);
+            }
+            lastSeen = std::max(lastSeen, record.lsn);
+            valid += RECORD_BYTES;
+        }
+        if (valid != bytes.size()) {
+            // Only the newest segment can end in a torn write; damage anywhere
+            // else would silently drop the records after it
+            if (s + 1 != segments.size()) {
+                tail.clear();
+                return false;
+            }
+            file.close();
+            std::error_code error;
+            std::filesystem::resize_file(segments[s].second, valid, error);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        buffer.clear();
+        nextLsn = lastSeen + 1;
+        durableLsn = lastSeen;
+        bytesSinceCheckpoint = 0;
+        rotateRequested = true;
+        stopping = false;
+        writeFailed = false;
+        currentSegment = 0;
+    }
+    checkpointFailed = false;
+    writer = std::thread(&Journal::writerLoop, this);
+    isOpen = true;
+    return true;
+}
+
+void Journal::close() {
+    if (!isOpen) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    queued.notify_all();
+    writer.join();
+    waitForCheckpoint();
+    isOpen = false;
+}
+
+uint64_t Journal::append(RecordType type, const Measurement& m) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Record record = {nextLsn++, type, m};
+    size_t at = buffer.size();
+    buffer.resize(at + RECORD_BYTES);
+    encodeRecord(record, buffer.data() + at);
+    bytesSinceCheckpoint += RECORD_BYTES;
+    queued.notify_one();
+    return record.lsn;
+}
+
+bool Journal::sync() {
+    std::unique_lock<std::mutex> lock(mutex);
+    uint64_t target = nextLsn - 1;
+    durable.wait(lock, [&]() { return durableLsn >= target || writeFailed; });
+    return !writeFailed && !checkpointFailed;
+}
+
+uint64_t Journal::lastLsn() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return nextLsn - 1;
+}
+
+void Journal::writerLoop() {
+    std::vector<unsigned char> batch;
+    while (true) {
+        uint64_t batchLast;
+        bool rotate;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            queued.wait(lock, [this]() { return stopping || !buffer.empty(); });
+            if (buffer.empty()) break;
+            // Everything queued while the last write was in flight goes out together
+            batch.swap(buffer);
+            buffer.clear();
+            batchLast = nextLsn - 1;
+            rotate = rotateRequested || segment == nullptr || segmentBytes >= SEGMENT_BYTES;
+            rotateRequested = false;
+        }
+
+        bool ok = true;
+        if (rotate) {
+            if (segment != nullptr) std::fclose(segment);
+            uint64_t firstLsn;
+            std::memcpy(&firstLsn, batch.data() + 8, 8);
+            std::string name = segmentName(firstLsn);
+            segment = std::fopen(name.c_str(), "ab");
+            segmentBytes = 0;
+            // The new directory entry must be durable before any record in it is
+            ok = segment != nullptr && FileSync::syncDirectory(name);
+            std::lock_guard<std::mutex> lock(mutex);
+            currentSegment = firstLsn;
+        }
+        if (ok) {
+            ok = std::fwrite(batch.data(), 1, batch.size(), segment) == batch.size() && FileSync::flush(segment);
+            segmentBytes += batch.size();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (ok) {
+                durableLsn = batchLast;
+            } else {
+                writeFailed = true;
+            }
+        }
+        durable.notify_all();
+    }
+
+    if (segment != nullptr) {
+        std::fclose(segment);
+        segment = nullptr;
+    }
+}
+
+bool Journal::checkpointDue() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bytesSinceCheckpoint >= CHECKPOINT_BYTES && !checkpointRunning;
+}
+
+bool Journal::checkpoint(MeasurementColumns columns) {
+    if (!isOpen || checkpointRunning) return false;
+    if (checkpointer.joinable()) checkpointer.join();
+
+    uint64_t lsn;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        lsn = nextLsn - 1;
+        bytesSinceCheckpoint = 0;
+        // Later records start a fresh segment, so the current one can go
+        rotateRequested = true;
+    }
+    checkpointRunning = true;
+    checkpointer = std::thread(&Journal::writeCheckpoint, this, std::move(columns), lsn);
+    return true;
+}
+
+bool Journal::waitForCheckpoint() {
+    if (checkpointer.joinable()) checkpointer.join();
+    return !checkpointFailed;
+}
+
+const std::string& Journal::getBasePath() const {
+    return basePath;
+}
+
+void Journal::writeCheckpoint(MeasurementColumns columns, uint64_t lsn) {
+    std::string snapshotFile = basePath + ".wsnap";
+    // Snapshot::save syncs the directory after its rename, so the snapshot
+    // is durable before any segment it covers is deleted
+    bool saved = Snapshot::save(snapshotFile, columns, lsn);
+    if (saved) {
+        // A segment is covered once the next one starts at or before lsn + 1
+        std::vector<std::pair<uint64_t, std::string>> segments = listSegments();
+        uint64_t current;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            current = currentSegment;
+        }
+        for (size_t s = 0; s + 1 < segments.size(); s++) {
+            if (segments[s + 1].first <= lsn + 1 && segments[s].first != current) {
+                std::remove(segments[s].second.c_str());
+            }
+        }
+    }
+    checkpointFailed = !saved;
+    checkpointRunning = false;
+}
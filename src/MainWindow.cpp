@@ -3,9 +3,14 @@
 #include <QGridLayout>
 #include <QSizePolicy>
 #include <QTableWidgetItem>
+#include <QItemSelectionModel>
+#include <QFileInfo>
+#include "Timestamp.h"
 
-MainWindow::MainWindow(QWidget *parent):QMainWindow(parent), nextId(1), dataFile("data/measurements.txt")
+MainWindow::MainWindow(QWidget *parent):QMainWindow(parent), nextId(1), dataFile("data/measurements.txt"), followOffset(0), reloadBeforeFollow(false)
 {
+    followTimer = new QTimer(this);
+    connect(followTimer, &QTimer::timeout, this, &MainWindow::followFile);
     setupUI();
     setWindowTitle("Weather Station");
     setMinimumSize(800, 800);
@@ -78,6 +83,7 @@ void MainWindow::createTableSection(QVBoxLayout *mainLayout) {
     measurementTable->horizontalHeader()->setStretchLastSection(true);
     measurementTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
     measurementTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    measurementTable->setSelectionMode(QAbstractItemView::ExtendedSelection);
     measurementTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
     measurementTable->setAlternatingRowColors(true);
     measurementTable->verticalHeader()->setVisible(false);
@@ -103,6 +109,9 @@ void MainWindow::createButtonSection(QVBoxLayout *mainLayout) {
     buttonLayout->addWidget(setupButton("Load from File", "loadBtn", &MainWindow::loadFromFile));
     buttonLayout->addWidget(setupButton("Save to File", "saveBtn", &MainWindow::saveToFile));
     buttonLayout->addWidget(setupButton("Refresh Stats", "statsBtn", &MainWindow::showStatistics));
+    followButton = setupButton("Follow File", "followBtn", &MainWindow::toggleFollow);
+    followButton->setCheckable(true);
+    buttonLayout->addWidget(followButton);
 
     mainLayout->addLayout(buttonLayout);
 }
@@ -147,15 +156,16 @@ void MainWindow::addMeasurement() {
     float wind = windSpeedEdit->text().toFloat(&windOk);
     
     // Auto-generate date and time from system
-    QString date = QDate::currentDate().toString("dd/MM/yyyy");
-    QString time = QTime::currentTime().toString("HH:mm");
+    QDateTime now = QDateTime::currentDateTime();
+    int64_t timestamp = Timestamp::fromCivil(now.date().year(), now.date().month(), now.date().day(),
+                                             now.time().hour(), now.time().minute());
 
     if (!tempOk || !humOk || !windOk) {
         QMessageBox::warning(this, "Invalid Input", "Please enter valid values for temperature, humidity, and wind speed.");
         return;
     }
 
-    Measurement m(nextId, temp, hum, wind, date.toStdString(), time.toStdString());
+    Measurement m(nextId, temp, hum, wind, timestamp);
     station.addMeasurement(m);
     nextId++;
 
@@ -170,42 +180,122 @@ void MainWindow::addMeasurement() {
 }
 
 void MainWindow::deleteMeasurement() {
-    int currentRow = measurementTable->currentRow();
-    if (currentRow < 0) {
+    const QModelIndexList selectedRows = measurementTable->selectionModel()->selectedRows();
+    if (selectedRows.isEmpty()) {
         QMessageBox::warning(this, "No Selection", "Please select a measurement to delete.");
         return;
     }
 
-    int id = measurementTable->item(currentRow, 0)->text().toInt();
-    if (station.removeMeasurement(id)) {
+    // Table rows are the station's slots (see refreshTable), so exactly the
+    // selected rows go even when ids repeat
+    std::vector<size_t> slots;
+    slots.reserve(selectedRows.size());
+    for (const QModelIndex &index : selectedRows) {
+        slots.push_back(static_cast<size_t>(index.row()));
+    }
+
+    size_t removed = station.removeMeasurementsAt(slots);
+    if (removed > 0) {
         refreshTable();
         showStatistics();
-        QMessageBox::information(this, "Success", "Measurement deleted successfully!");
+        QMessageBox::information(this, "Success", QString("%1 measurement(s) deleted successfully!").arg(removed));
     } else {
         QMessageBox::warning(this, "Error", "Could not delete measurement.");
     }
 }
 
 void MainWindow::loadFromFile() {
+    // The follower's offset would not match the reloaded contents
+    if (follower.isOpen()) {
+        toggleFollow();
+    }
     if (station.loadFromFile(dataFile.toStdString())) {
-        // Update nextId based on loaded data
-        const auto& measurements = station.getMeasurements();
-        nextId = 1;
-        for (const auto& m : measurements) {
-            if (m.getId() >= nextId) {
-                nextId = m.getId() + 1;
-            }
+        const WeatherStation::LoadStats& stats = station.getLastLoadStats();
+        followOffset = stats.lineEnd;
+        // The last line had no '\n' yet and was parsed anyway
+        reloadBeforeFollow = stats.lineEnd != stats.bytes;
+        showLoadedData();
+        if (stats.rejected > 0) {
+            QMessageBox::warning(this, "Warning", QString("Data loaded, but %1 line(s) with a bad date or time were skipped.").arg(stats.rejected));
+            return;
         }
-        refreshTable();
-        showStatistics();
         QMessageBox::information(this, "Success", "Data loaded from file successfully!");
     } else {
         QMessageBox::warning(this, "Error", "Could not load data from file.");
     }
 }
 
+void MainWindow::showLoadedData() {
+    // Update nextId based on loaded data
+    const auto& measurements = station.getMeasurements();
+    nextId = 1;
+    for (const auto& m : measurements) {
+        if (m.getId() >= nextId) {
+            nextId = m.getId() + 1;
+        }
+    }
+    refreshTable();
+    showStatistics();
+}
+
+void MainWindow::toggleFollow() {
+    if (follower.isOpen()) {
+        followTimer->stop();
+        followOffset = follower.getOffset();
+        follower.close();
+        followButton->setChecked(false);
+        return;
+    }
+
+    // A writer may still be in the middle of a last line without its '\n',
+    // so reload up to the last complete line and follow from there
+    if (reloadBeforeFollow) {
+        if (!station.loadFromFile(dataFile.toStdString(), WeatherStation::LoadMode::Parallel, true)) {
+            followButton->setChecked(false);
+            QMessageBox::warning(this, "Error", "Could not load data from file.");
+            return;
+        }
+        followOffset = station.getLastLoadStats().lineEnd;
+        reloadBeforeFollow = false;
+        showLoadedData();
+    }
+
+    // Pick up where Load or the last follow left off
+    if (!follower.open(dataFile.toStdString(), followOffset)) {
+        followButton->setChecked(false);
+        QMessageBox::warning(this, "Error", "Could not open data file.");
+        return;
+    }
+    followButton->setChecked(true);
+    followFile();
+    followTimer->start(500);
+}
+
+void MainWindow::followFile() {
+    size_t added = follower.poll(station);
+    if (added == 0) {
+        return;
+    }
+    // New rows are appended at the end
+    const auto& measurements = station.getMeasurements();
+    for (size_t i = measurements.size() - added; i < measurements.size(); i++) {
+        if (measurements[i].getId() >= nextId) {
+            nextId = measurements[i].getId() + 1;
+        }
+    }
+    refreshTable();
+    showStatistics();
+}
+
 void MainWindow::saveToFile() {
+    // Saving rewrites the followed file in place, so the follower's offset
+    // no longer matches it; the file now holds exactly the station's rows
+    if (follower.isOpen()) {
+        toggleFollow();
+    }
     if (station.saveToFile(dataFile.toStdString())) {
+        followOffset = static_cast<uint64_t>(QFileInfo(dataFile).size());
+        reloadBeforeFollow = false;
         QMessageBox::information(this, "Success", "Data saved to file successfully!");
     } else {
         QMessageBox::warning(this, "Error", "Could not save data to file.");
@@ -213,9 +303,9 @@ void MainWindow::saveToFile() {
 }
 
 void MainWindow::showStatistics() {
-    const auto& measurements = station.getMeasurements();
-    
-    if (measurements.empty()) {
+    Analyzer::Summary summary = station.getStatistics();
+
+    if (summary.count() == 0) {
         avgTempLabel->setText("Avg: --");
         minTempLabel->setText("Min: --");
         maxTempLabel->setText("Max: --");
@@ -224,17 +314,26 @@ void MainWindow::showStatistics() {
         return;
     }
 
-    float avgTemp = Analyzer::averageTemperature(measurements);
-    float minTemp = Analyzer::minTemperature(measurements);
-    float maxTemp = Analyzer::maxTemperature(measurements);
-    float avgHum = Analyzer::averageHumidity(measurements);
-    float avgWind = Analyzer::averageWindSpeed(measurements);
-
-    avgTempLabel->setText(QString("Avg: %1°C").arg(avgTemp, 0, 'f', 1));
-    minTempLabel->setText(QString("Min: %1°C").arg(minTemp, 0, 'f', 1));
-    maxTempLabel->setText(QString("Max: %1°C").arg(maxTemp, 0, 'f', 1));
-    avgHumidityLabel->setText(QString("Humidity: %1%").arg(avgHum, 0, 'f', 1));
-    avgWindLabel->setText(QString("Wind: %1 km/h").arg(avgWind, 0, 'f', 1));
+    float avgTemp = summary.temperature.mean;
+    float minTemp = summary.temperature.min;
+    float maxTemp = summary.temperature.max;
+    float avgHum = summary.humidity.mean;
+    float avgWind = summary.windSpeed.mean;
+
+    // A field can be empty on its own when all its values are NaN
+    if (summary.temperature.count > 0) {
+        avgTempLabel->setText(QString("Avg: %1°C").arg(avgTemp, 0, 'f', 1));
+        minTempLabel->setText(QString("Min: %1°C").arg(minTemp, 0, 'f', 1));
+        maxTempLabel->setText(QString("Max: %1°C").arg(maxTemp, 0, 'f', 1));
+    } else {
+        avgTempLabel->setText("Avg: --");
+        minTempLabel->setText("Min: --");
+        maxTempLabel->setText("Max: --");
+    }
+    avgHumidityLabel->setText(summary.humidity.count > 0 ? QString("Humidity: %1%").arg(avgHum, 0, 'f', 1)
+                                                         : QString("Humidity: --"));
+    avgWindLabel->setText(summary.windSpeed.count > 0 ? QString("Wind: %1 km/h").arg(avgWind, 0, 'f', 1)
+                                                      : QString("Wind: --"));
 }
 
 void MainWindow::refreshTable() {
@@ -12,8 +12,10 @@
 #include <QMessageBox>
 #include <QFileDialog>
 #include <QDateTime>
+#include <QTimer>
 #include "WeatherStation.h"
 #include "Analyzer.h"
+#include "TailFollower.h"
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -29,6 +31,8 @@ private slots:
     void saveToFile();
     void showStatistics();
     void refreshTable();
+    void toggleFollow();
+    void followFile();
 
 private:
     void setupUI();
@@ -36,12 +40,22 @@ private:
     void createTableSection(QVBoxLayout *mainLayout);
     void createButtonSection(QVBoxLayout *mainLayout);
     void createStatsSection(QVBoxLayout *mainLayout);
+    void showLoadedData();
 
     // Data
     WeatherStation station;
     int nextId;
     QString dataFile;
 
+    // Follow mode: the timer polls the data file for appended lines.
+    // followOffset is where following resumes: just past the last line of
+    // the data file that the station already holds.
+    uint64_t followOffset;
+    bool reloadBeforeFollow;
+    TailFollower follower;
+    QTimer *followTimer;
+    QPushButton *followButton;
+
     // Input fields
     QLineEdit *temperatureEdit;
     QLineEdit *humidityEdit;
@@ -1,51 +1,156 @@
 #include "Measurement.h"
+#include "Timestamp.h"
+#include <charconv>
+#include <cmath>
 #include <iostream>
-#include <sstream>
+#include <type_traits>
+
+static_assert(sizeof(Measurement) == 24, "Measurement must stay a packed 24-byte record");
+static_assert(std::is_trivially_copyable<Measurement>::value, "Measurement must stay trivially copyable");
+
+namespace {
+
+const double POWERS_OF_TEN[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+
+// %g with precision 6 for the fixed-notation range 1e-4 <= |value| < 1e6,
+// which covers every sensor reading. A float times 10^k (k <= 9) is exact
+// in a double, so rounding the product to an integer rounds exactly like
+// printf does, ties included. Everything else goes through to_chars.
+char* formatGeneral(char* out, char* end, float value) {
+    double magnitude = std::fabs(static_cast<double>(value));
+    if (!(magnitude >= 1e-4 && magnitude < 1e6)) {
+        return std::to_chars(out, end, value, std::chars_format::general, 6).ptr;
+    }
+    int scale = 0;
+    while (magnitude * POWERS_OF_TEN[scale] < 1e5) {
+        scale++;
+    }
+    uint32_t rounded = static_cast<uint32_t>(std::nearbyint(magnitude * POWERS_OF_TEN[scale]));
+    if (rounded == 1000000) {
+        if (scale == 0) {
+            return std::to_chars(out, end, value, std::chars_format::general, 6).ptr;
+        }
+        scale--;
+        rounded = 100000;
+    }
+
+    char digits[6];
+    for (int i = 5; i >= 0; i--) {
+        digits[i] = static_cast<char>('0' + rounded % 10);
+        rounded /= 10;
+    }
+    int last = 5;
+    while (last > 0 && digits[last] == '0') {
+        last--;
+    }
+
+    if (value < 0) {
+        *out++ = '-';
+    }
+    int integerDigits = 6 - scale;
+    if (integerDigits <= 0) {
+        *out++ = '0';
+        *out++ = '.';
+        for (int i = integerDigits; i < 0; i++) {
+            *out++ = '0';
+        }
+        for (int i = 0; i <= last; i++) {
+            *out++ = digits[i];
+        }
+        return out;
+    }
+    for (int i = 0; i < integerDigits; i++) {
+        *out++ = digits[i];
+    }
+    if (last >= integerDigits) {
+        *out++ = '.';
+        for (int i = integerDigits; i <= last; i++) {
+            *out++ = digits[i];
+        }
+    }
+    return out;
+}
+
+}
 
 Measurement::Measurement() {
+    timestamp = 0;
     id = 0;
     temperature = 0.0f;
     humidity = 0.0f;
     windSpeed = 0.0f;
-    date = "";
-    time = "";
 }
 
-Measurement::Measurement(int id, float temp, float hum, float wind, std::string d, std::string t) {
+Measurement::Measurement(int id, float temp, float hum, float wind, int64_t timestamp) {
+    this->timestamp = timestamp;
     this->id = id;
     this->temperature = temp;
     this->humidity = hum;
     this->windSpeed = wind;
-    this->date = d;
-    this->time = t;
 }
 
 int Measurement::getId() const { return id; }
 float Measurement::getTemperature() const { return temperature; }
 float Measurement::getHumidity() const { return humidity; }
 float Measurement::getWindSpeed() const { return windSpeed; }
-std::string Measurement::getDate() const { return date; }
-std::string Measurement::getTime() const { return time; }
+int64_t Measurement::getTimestamp() const { return timestamp; }
+std::string Measurement::getDate() const { return Timestamp::dateString(timestamp); }
+std::string Measurement::getTime() const { return Timestamp::timeString(timestamp); }
 
 void Measurement::setId(int id) { this->id = id; }
 void Measurement::setTemperature(float temp) { this->temperature = temp; }
 void Measurement::setHumidity(float hum) { this->humidity = hum; }
 void Measurement::setWindSpeed(float wind) { this->windSpeed = wind; }
-void Measurement::setDate(std::string d) { this->date = d; }
-void Measurement::setTime(std::string t) { this->time = t; }
+void Measurement::setTimestamp(int64_t timestamp) { this->timestamp = timestamp; }
+
+bool Measurement::setDate(std::string d) {
+    int64_t days;
+    if (!Timestamp::parseDate(d.data(), d.data() + d.size(), days)) {
+        return false;
+    }
+    timestamp = days * Timestamp::MINUTES_PER_DAY + Timestamp::minuteOfDay(timestamp);
+    return true;
+}
+
+bool Measurement::setTime(std::string t) {
+    int minuteOfDay;
+    if (!Timestamp::parseTime(t.data(), t.data() + t.size(), minuteOfDay)) {
+        return false;
+    }
+    timestamp = Timestamp::dayNumber(timestamp) * Timestamp::MINUTES_PER_DAY + minuteOfDay;
+    return true;
+}
 
 void Measurement::display() const {
     std::cout << "ID: " << id << std::endl;
     std::cout << "Temperature: " << temperature << " C" << std::endl;
     std::cout << "Humidity: " << humidity << " %" << std::endl;
     std::cout << "Wind Speed: " << windSpeed << " km/h" << std::endl;
-    std::cout << "Date: " << date << std::endl;
-    std::cout << "Time: " << time << std::endl;
+    std::cout << "Date: " << getDate() << std::endl;
+    std::cout << "Time: " << getTime() << std::endl;
     std::cout << "------------------------" << std::endl;
 }
 
 std::string Measurement::toTextLine() const {
-    std::stringstream ss;
-    ss << id << ";" << temperature << ";" << humidity << ";" << windSpeed << ";" << date << ";" << time;
-    return ss.str();
+    char buffer[MAX_TEXT_LINE];
+    return std::string(buffer, formatTextLine(buffer));
+}
+
+// Floats use %g-style formatting with 6 significant digits, which is what
+// the stream operator printed before, so files stay byte-identical.
+// Shortest round-trip output would differ for values like 0.1f + 0.2f.
+char* Measurement::formatTextLine(char* out) const {
+    char* end = out + MAX_TEXT_LINE;
+    out = std::to_chars(out, end, id).ptr;
+    const float values[3] = {temperature, humidity, windSpeed};
+    for (float value : values) {
+        *out++ = ';';
+        out = formatGeneral(out, end, value);
+    }
+    *out++ = ';';
+    Timestamp::formatDate(timestamp, out);
+    out += 10;
+    *out++ = ';';
+    Timestamp::formatTime(timestamp, out);
+    return out + 5;
 }
@@ -0,0 +1,73 @@
+#include "MeasurementColumns.h"
+
+void MeasurementColumns::clear() {
+    ids.clear();
+    temperatures.clear();
+    humidities.clear();
+    windSpeeds.clear();
+    timestamps.clear();
+}
+
+void MeasurementColumns::reserve(size_t count) {
+    ids.reserve(count);
+    temperatures.reserve(count);
+    humidities.reserve(count);
+    windSpeeds.reserve(count);
+    timestamps.reserve(count);
+}
+
+void MeasurementColumns::append(const Measurement& m) {
+    ids.push_back(m.getId());
+    temperatures.push_back(m.getTemperature());
+    humidities.push_back(m.getHumidity());
+    windSpeeds.push_back(m.getWindSpeed());
+    timestamps.push_back(m.getTimestamp());
+}
+
+void MeasurementColumns::erase(size_t slot) {
+    ids.erase(ids.begin() + slot);
+    temperatures.erase(temperatures.begin() + slot);
+    humidities.erase(humidities.begin() + slot);
+    windSpeeds.erase(windSpeeds.begin() + slot);
+    timestamps.erase(timestamps.begin() + slot);
+}
+
+void MeasurementColumns::assign(const std::vector<Measurement>& measurements) {
+    size_t count = measurements.size();
+    ids.resize(count);
+    temperatures.resize(count);
+    humidities.resize(count);
+    windSpeeds.resize(count);
+    timestamps.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        const Measurement& m = measurements[i];
+        ids[i] = m.getId();
+        temperatures[i] = m.getTemperature();
+        humidities[i] = m.getHumidity();
+        windSpeeds[i] = m.getWindSpeed();
+        timestamps[i] = m.getTimestamp();
+    }
+}
+
+void MeasurementColumns::assign(std::vector<int>&& newIds, std::vector<float>&& newTemperatures,
+                                std::vector<float>&& newHumidities, std::vector<float>&& newWindSpeeds,
+                                std::vector<int64_t>&& newTimestamps) {
+    ids = std::move(newIds);
+    temperatures = std::move(newTemperatures);
+    humidities = std::move(newHumidities);
+    windSpeeds = std::move(newWindSpeeds);
+    timestamps = std::move(newTimestamps);
+}
+
+size_t MeasurementColumns::size() const { return ids.size(); }
+bool MeasurementColumns::empty() const { return ids.empty(); }
+
+Measurement MeasurementColumns::row(size_t slot) const {
+    return Measurement(ids[slot], temperatures[slot], humidities[slot], windSpeeds[slot], timestamps[slot]);
+}
+
+std::span<const int> MeasurementColumns::getIds() const { return ids; }
+std::span<const float> MeasurementColumns::getTemperatures() const { return temperatures; }
+std::span<const float> MeasurementColumns::getHumidities() const { return humidities; }
+std::span<const float> MeasurementColumns::getWindSpeeds() const { return windSpeeds; }
+std::span<const int64_t> MeasurementColumns::getTimestamps() const { return timestamps; }
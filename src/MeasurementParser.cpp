@@ -0,0 +1,210 @@
+#include "MeasurementParser.h"
+#include "FieldScanner.h"
+#include "ThreadPool.h"
+#include "Timestamp.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace {
+
+// from_chars is stricter than atoi/atof: skip the leading blanks and '+'
+// they accept so both loaders agree on the same input.
+const char* skipNumberPrefix(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    if (p < end && *p == '+') p++;
+    return p;
+}
+
+int parseInt(const char* p, const char* end) {
+    int value = 0;
+    std::from_chars(skipNumberPrefix(p, end), end, value);
+    return value;
+}
+
+float parseFloat(const char* p, const char* end) {
+    float value = 0.0f;
+    std::from_chars(skipNumberPrefix(p, end), end, value);
+    return value;
+}
+
+// Below this a chunk is not worth a thread of its own
+const size_t MIN_CHUNK_BYTES = 1 << 20;
+
+// Text handed to the field scanner at once; small enough to stay in L2
+const size_t BLOCK_BYTES = 256 * 1024;
+
+const int MAX_FIELDS = 6;
+
+const char* nextField(const char* p, const char* end) {
+    const void* hit = std::memchr(p, ';', end - p);
+    return hit ? static_cast<const char*>(hit) : end;
+}
+
+// End of the block starting at block: just past its last complete line,
+// or past the first newline when a single line is longer than a block.
+const char* blockBoundary(const char* block, const char* end) {
+    if (static_cast<size_t>(end - block) <= BLOCK_BYTES) return end;
+
+    const char* limit = block + BLOCK_BYTES;
+    for (const char* p = limit; p > block; p--) {
+        if (p[-1] == '\n') return p;
+    }
+    const void* hit = std::memchr(limit, '\n', end - limit);
+    return hit ? static_cast<const char*>(hit) + 1 : end;
+}
+
+bool buildMeasurement(const char* const* fields, const char* const* fieldEnds, int count,
+                      const char* lineEnd, Measurement& out) {
+    int id = parseInt(fields[0], fieldEnds[0]);
+    float temp = count > 1 ? parseFloat(fields[1], fieldEnds[1]) : 0.0f;
+    float hum = count > 2 ? parseFloat(fields[2], fieldEnds[2]) : 0.0f;
+    float wind = count > 3 ? parseFloat(fields[3], fieldEnds[3]) : 0.0f;
+
+    // Date and time go straight into the packed timestamp, no strings involved.
+    // Legacy files have no time column, and "date;" counts as missing too,
+    // so the time stays at "00:00".
+    int64_t days;
+    int minuteOfDay = 0;
+    if (count <= 4 || !Timestamp::parseDate(fields[4], fieldEnds[4], days)) {
+        return false;
+    }
+    if (count > 5 && fields[5] != lineEnd && !Timestamp::parseTime(fields[5], fieldEnds[5], minuteOfDay)) {
+        return false;
+    }
+
+    out = Measurement(id, temp, hum, wind, days * Timestamp::MINUTES_PER_DAY + minuteOfDay);
+    return true;
+}
+
+}
+
+bool MeasurementParser::parseLine(const char* begin, const char* end, Measurement& out) {
+    if (end > begin && end[-1] == '\r') end--;
+    if (begin == end) return false;
+
+    const char* fields[MAX_FIELDS];
+    const char* fieldEnds[MAX_FIELDS];
+    int count = 0;
+    const char* p = begin;
+    while (count < MAX_FIELDS) {
+        const char* stop = nextField(p, end);
+        fields[count] = p;
+        fieldEnds[count] = stop;
+        count++;
+        if (stop == end) break;
+        p = stop + 1;
+    }
+
+    return buildMeasurement(fields, fieldEnds, count, end, out);
+}
+
+size_t MeasurementParser::parseBuffer(const char* begin, const char* end, std::vector<Measurement>& out,
+                                      size_t* rejected) {
+    size_t parsed = 0;
+    size_t skipped = 0;
+    std::vector<uint32_t> index;
+    const char* fields[MAX_FIELDS];
+    const char* fieldEnds[MAX_FIELDS];
+    Measurement m;
+
+    const char* block = begin;
+    while (block < end) {
+        const char* blockEnd = blockBoundary(block, end);
+        FieldScanner::buildIndex(block, blockEnd, index);
+
+        // Walk the delimiter index field by field instead of byte by byte
+        const char* lineStart = block;
+        int count = 0;
+        fields[0] = lineStart;
+        auto finishLine = [&](const char* lineEnd) {
+            if (lineEnd > lineStart && lineEnd[-1] == '\r') lineEnd--;
+            if (count < MAX_FIELDS) {
+                fieldEnds[count] = lineEnd;
+                count++;
+            }
+            if (lineEnd > lineStart) {
+                if (buildMeasurement(fields, fieldEnds, count, lineEnd, m)) {
+                    out.push_back(m);
+                    parsed++;
+                } else {
+                    skipped++;
+                }
+            }
+        };
+
+        for (uint32_t offset : index) {
+            const char* delim = block + offset;
+            if (*delim == ';') {
+                if (count < MAX_FIELDS) {
+                    fieldEnds[count] = delim;
+                    count++;
+                    if (count < MAX_FIELDS) fields[count] = delim + 1;
+                }
+                continue;
+            }
+            finishLine(delim);
+            lineStart = delim + 1;
+            count = 0;
+            fields[0] = lineStart;
+        }
+        if (lineStart < blockEnd) {
+            finishLine(blockEnd);
+        }
+
+        block = blockEnd;
+    }
+    if (rejected != nullptr) {
+        *rejected += skipped;
+    }
+    return parsed;
+}
+
+size_t MeasurementParser::parseBufferParallel(const char* begin, const char* end, std::vector<Measurement>& out,
+                                              unsigned threadCount, size_t* rejected) {
+    size_t bytes = end - begin;
+    if (threadCount == 0) {
+        threadCount = static_cast<unsigned>(ThreadPool::shared().size() + 1);
+    }
+    size_t chunkCount = std::min<size_t>(threadCount, bytes / MIN_CHUNK_BYTES);
+    if (chunkCount <= 1) {
+        return parseBuffer(begin, end, out, rejected);
+    }
+
+    // Move each cut forward to just past the next newline so no line is split
+    std::vector<const char*> cuts(chunkCount + 1);
+    cuts[0] = begin;
+    cuts[chunkCount] = end;
+    for (size_t i = 1; i < chunkCount; i++) {
+        const char* guess = std::max(begin + bytes / chunkCount * i, cuts[i - 1]);
+        const void* hit = std::memchr(guess, '\n', end - guess);
+        cuts[i] = hit ? static_cast<const char*>(hit) + 1 : end;
+    }
+
+    std::vector<std::vector<Measurement>> parts(chunkCount);
+    std::vector<size_t> skipped(chunkCount, 0);
+    ThreadPool& pool = ThreadPool::shared();
+    pool.parallelFor(chunkCount, [&](size_t i) {
+        parts[i].reserve((cuts[i + 1] - cuts[i]) / 32);
+        parseBuffer(cuts[i], cuts[i + 1], parts[i], &skipped[i]);
+    });
+    if (rejected != nullptr) {
+        for (size_t count : skipped) {
+            *rejected += count;
+        }
+    }
+
+    // Merge in file order; the moves into the final slots also run in parallel
+    size_t first = out.size();
+    std::vector<size_t> offsets(chunkCount + 1, first);
+    for (size_t i = 0; i < chunkCount; i++) {
+        offsets[i + 1] = offsets[i] + parts[i].size();
+    }
+    out.resize(offsets[chunkCount]);
+    pool.parallelFor(chunkCount, [&](size_t i) {
+        std::move(parts[i].begin(), parts[i].end(), out.begin() + offsets[i]);
+        std::vector<Measurement>().swap(parts[i]);
+    });
+
+    return offsets[chunkCount] - first;
+}
@@ -0,0 +1,159 @@
+#include "QuantileSketch.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+const size_t MIN_CAPACITY = 8;
+const double LEVEL_RATIO = 2.0 / 3.0;
+
+}
+
+QuantileSketch::QuantileSketch(int k)
+    : k(k < 8 ? 8 : k), count(0), retained(0), minValue(0.0f), maxValue(0.0f), levels(1), coin(12345) {
+    updateCapacities();
+}
+
+// A level's capacity depends on its distance from the top, so every one
+// changes when a level is added; nothing else changes them
+void QuantileSketch::updateCapacities() {
+    capacities.resize(levels.size());
+    totalCapacity = 0;
+    for (size_t h = 0; h < levels.size(); h++) {
+        size_t depth = levels.size() - 1 - h;
+        size_t cap = static_cast<size_t>(std::ceil(k * std::pow(LEVEL_RATIO, static_cast<double>(depth))));
+        capacities[h] = std::max(cap, MIN_CAPACITY);
+        totalCapacity += capacities[h];
+    }
+}
+
+void QuantileSketch::compressWhileFull() {
+    while (retained >= totalCapacity) {
+        for (size_t h = 0; h < levels.size(); h++) {
+            if (levels[h].size() < capacities[h]) continue;
+
+            if (h + 1 == levels.size()) {
+                levels.emplace_back();
+                updateCapacities();
+            }
+            std::vector<float>& current = levels[h];
+            std::vector<float>& above = levels[h + 1];
+            std::sort(current.begin(), current.end());
+
+            // An odd item out stays behind so the promoted weight is exact
+            size_t pairs = current.size() / 2;
+            size_t offset = coin() & 1;
+            for (size_t i = 0; i < pairs; i++) {
+                above.push_back(current[2 * i + offset]);
+            }
+            float leftover = current.back();
+            bool keepLeftover = current.size() % 2 == 1;
+            retained -= pairs;
+            current.clear();
+            if (keepLeftover) {
+                current.push_back(leftover);
+            }
+            break;
+        }
+    }
+}
+
+void QuantileSketch::add(float value) {
+    if (std::isnan(value)) return;
+
+    if (count == 0) {
+        minValue = value;
+        maxValue = value;
+    } else {
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
+    }
+    count++;
+    levels[0].push_back(value);
+    retained++;
+    if (retained >= totalCapacity) {
+        compressWhileFull();
+    }
+}
+
+void QuantileSketch::add(std::span<const float> values) {
+    for (float v : values) {
+        add(v);
+    }
+}
+
+bool QuantileSketch::merge(const QuantileSketch& other) {
+    // Compactors of different sizes would void the error bound
+    if (other.k != k) return false;
+    if (other.count == 0) return true;
+
+    if (count == 0) {
+        minValue = other.minValue;
+        maxValue = other.maxValue;
+    } else {
+        minValue = std::min(minValue, other.minValue);
+        maxValue = std::max(maxValue, other.maxValue);
+    }
+    count += other.count;
+
+    if (levels.size() < other.levels.size()) {
+        levels.resize(other.levels.size());
+        updateCapacities();
+    }
+    for (size_t h = 0; h < other.levels.size(); h++) {
+        levels[h].insert(levels[h].end(), other.levels[h].begin(), other.levels[h].end());
+        retained += other.levels[h].size();
+    }
+    compressWhileFull();
+    return true;
+}
+
+size_t QuantileSketch::size() const { return count; }
+bool QuantileSketch::empty() const { return count == 0; }
+
+double QuantileSketch::epsilon() const {
+    // Empirical 99%-confidence fit for KLL with the 2/3 level ratio
+    return 2.296 / std::pow(static_cast<double>(k), 0.9723);
+}
+
+float QuantileSketch::quantile(double q) const {
+    return quantiles({q})[0];
+}
+
+std::vector<float> QuantileSketch::quantiles(const std::vector<double>& qs) const {
+    std::vector<float> result(qs.size(), 0.0f);
+    if (count == 0) return result;
+
+    std::vector<std::pair<float, uint64_t>> weighted;
+    weighted.reserve(retained);
+    for (size_t h = 0; h < levels.size(); h++) {
+        for (float v : levels[h]) {
+            weighted.emplace_back(v, uint64_t(1) << h);
+        }
+    }
+    std::sort(weighted.begin(), weighted.end());
+
+    for (size_t i = 0; i < qs.size(); i++) {
+        double q = qs[i];
+        if (q <= 0.0) {
+            result[i] = minValue;
+            continue;
+        }
+        if (q >= 1.0) {
+            result[i] = maxValue;
+            continue;
+        }
+        double target = q * count;
+        uint64_t cumulative = 0;
+        result[i] = maxValue;
+        for (const auto& item : weighted) {
+            cumulative += item.second;
+            if (cumulative >= target) {
+                result[i] = item.first;
+                break;
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,119 @@
+#include "RangeAggregateIndex.h"
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const float INF = std::numeric_limits<float>::infinity();
+
+float fieldValue(const Measurement& m, int field) {
+    switch (field) {
+        case 0: return m.getTemperature();
+        case 1: return m.getHumidity();
+        default: return m.getWindSpeed();
+    }
+}
+
+}
+
+double RangeAggregateIndex::Aggregate::mean() const {
+    return count > 0 ? sum / count : 0.0;
+}
+
+const RangeAggregateIndex::Node RangeAggregateIndex::EMPTY = {0, 0.0, INF, -INF};
+
+void RangeAggregateIndex::clear() {
+    count = 0;
+    leaves = 0;
+    for (int f = 0; f < FIELD_COUNT; f++) {
+        trees[f].clear();
+    }
+}
+
+RangeAggregateIndex::Node RangeAggregateIndex::leaf(float value) {
+    return std::isnan(value) ? EMPTY : Node{1, value, value, value};
+}
+
+RangeAggregateIndex::Node RangeAggregateIndex::combine(const Node& l, const Node& r) {
+    return {l.count + r.count, l.sum + r.sum, l.min < r.min ? l.min : r.min, l.max > r.max ? l.max : r.max};
+}
+
+// Reallocates for at least minimum leaves, keeping the current samples
+void RangeAggregateIndex::grow(size_t minimum) {
+    size_t newLeaves = 1;
+    while (newLeaves < minimum) newLeaves *= 2;
+
+    for (int f = 0; f < FIELD_COUNT; f++) {
+        std::vector<Node> tree(2 * newLeaves, EMPTY);
+        for (size_t i = 0; i < count; i++) {
+            tree[newLeaves + i] = trees[f][leaves + i];
+        }
+        for (size_t i = newLeaves - 1; i >= 1; i--) {
+            tree[i] = combine(tree[2 * i], tree[2 * i + 1]);
+        }
+        trees[f].swap(tree);
+    }
+    leaves = newLeaves;
+}
+
+void RangeAggregateIndex::setLeaf(int field, size_t position, float value) {
+    std::vector<Node>& tree = trees[field];
+    size_t i = leaves + position;
+    tree[i] = leaf(value);
+    for (i /= 2; i >= 1; i /= 2) {
+        tree[i] = combine(tree[2 * i], tree[2 * i + 1]);
+    }
+}
+
+void RangeAggregateIndex::build(const TimeRange& series) {
+    clear();
+    leaves = 1;
+    while (leaves < series.size()) leaves *= 2;
+
+    for (int f = 0; f < FIELD_COUNT; f++) {
+        std::vector<Node>& tree = trees[f];
+        tree.assign(2 * leaves, EMPTY);
+        for (size_t i = 0; i < series.size(); i++) {
+            tree[leaves + i] = leaf(fieldValue(series[i], f));
+        }
+        for (size_t i = leaves - 1; i >= 1; i--) {
+            tree[i] = combine(tree[2 * i], tree[2 * i + 1]);
+        }
+    }
+    count = series.size();
+}
+
+void RangeAggregateIndex::append(const Measurement& m) {
+    if (count == leaves) {
+        grow(count + 1);
+    }
+    for (int f = 0; f < FIELD_COUNT; f++) {
+        setLeaf(f, count, fieldValue(m, f));
+    }
+    count++;
+}
+
+size_t RangeAggregateIndex::size() const {
+    return count;
+}
+
+RangeAggregateIndex::Aggregate RangeAggregateIndex::query(Field field, size_t first, size_t last) const {
+    Aggregate result;
+    if (last > count) last = count;
+    if (first >= last) return result;
+
+    const std::vector<Node>& tree = trees[static_cast<int>(field)];
+    Node total = EMPTY;
+    // Bottom-up walk over the half-open leaf interval
+    for (size_t l = first + leaves, r = last + leaves; l < r; l /= 2, r /= 2) {
+        if (l & 1) total = combine(total, tree[l++]);
+        if (r & 1) total = combine(total, tree[--r]);
+    }
+
+    result.count = total.count;
+    if (total.count == 0) return result;
+    result.sum = total.sum;
+    result.min = total.min;
+    result.max = total.max;
+    return result;
+}
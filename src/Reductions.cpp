@@ -0,0 +1,489 @@
+#include "Reductions.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Deviations squared are not exact in double, so a fused multiply-add would
+// round differently from a separate multiply and add. AVX-512 brings FMA
+// with it; keep the compiler from contracting so all kernels still agree.
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define REDUCTIONS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const size_t LANES = 16;
+
+// Per-lane partial results shared by every kernel: sums of the deviations
+// d = value - center and of d * d. The compensation arrays stay zero in
+// Fast mode. A NaN counts as a deviation of 0 and is left out of count.
+struct Lanes {
+    size_t nans = 0;
+    double sum[LANES];
+    double sumComp[LANES];
+    double sumSquares[LANES];
+    double squaresComp[LANES];
+    float min[LANES];
+    float max[LANES];
+
+    Lanes() {
+        for (size_t i = 0; i < LANES; i++) {
+            sum[i] = 0.0;
+            sumComp[i] = 0.0;
+            sumSquares[i] = 0.0;
+            squaresComp[i] = 0.0;
+            min[i] = std::numeric_limits<float>::infinity();
+            max[i] = -std::numeric_limits<float>::infinity();
+        }
+    }
+
+    // The one scalar step every kernel's arithmetic must match
+    template <bool Compensated>
+    void add(size_t lane, float value, double center) {
+        bool missing = std::isnan(value);
+        nans += missing;
+        double v = missing ? 0.0 : value - center;
+        if (Compensated) {
+            kahan(sum[lane], sumComp[lane], v);
+            kahan(sumSquares[lane], squaresComp[lane], v * v);
+        } else {
+            sum[lane] += v;
+            sumSquares[lane] += v * v;
+        }
+        min[lane] = value < min[lane] ? value : min[lane];
+        max[lane] = value > max[lane] ? value : max[lane];
+    }
+
+    static void kahan(double& total, double& comp, double value) {
+        double y = value - comp;
+        double t = total + y;
+        comp = (t - total) - y;
+        total = t;
+    }
+};
+
+// Turns the lanes into one block's result. The center is a value of the
+// block, so sumSquares - sum^2 / count cannot cancel much: the relative
+// error of m2 stays below about count * epsilon however far the values sit
+// from zero.
+template <bool Compensated>
+Reductions::Result fold(Lanes& lanes, const float* tail, size_t tailCount, size_t count, double center) {
+    for (size_t i = 0; i < tailCount; i++) {
+        lanes.add<Compensated>(i, tail[i], center);
+    }
+
+    Reductions::Result result;
+    count -= lanes.nans;
+    result.count = count;
+    if (count == 0) return result;
+
+    Reductions::Accumulator sum, sumSquares;
+    result.min = lanes.min[0];
+    result.max = lanes.max[0];
+    for (size_t i = 0; i < LANES; i++) {
+        sum.add(lanes.sum[i]);
+        sum.add(-lanes.sumComp[i]);
+        sumSquares.add(lanes.sumSquares[i]);
+        sumSquares.add(-lanes.squaresComp[i]);
+        result.min = lanes.min[i] < result.min ? lanes.min[i] : result.min;
+        result.max = lanes.max[i] > result.max ? lanes.max[i] : result.max;
+    }
+    double deviation = sum.value();
+    // count * center is exact: a float times at most BLOCK_VALUES
+    result.sum = count * center + deviation;
+    result.m2 = sumSquares.value() - deviation * (deviation / count);
+    // Only rounding can take it below zero
+    if (result.m2 < 0.0) result.m2 = 0.0;
+    return result;
+}
+
+template <bool Compensated>
+Reductions::Result reducePortable(const float* data, size_t count, double center) {
+    Lanes lanes;
+    size_t blocks = count / LANES;
+    for (size_t b = 0; b < blocks; b++) {
+        const float* p = data + b * LANES;
+        for (size_t i = 0; i < LANES; i++) {
+            lanes.add<Compensated>(i, p[i], center);
+        }
+    }
+    return fold<Compensated>(lanes, data + blocks * LANES, count % LANES, count, center);
+}
+
+// Min and max alone, in the same lanes as Lanes so the results match
+// reduce()'s bit for bit (which of -0 and +0 wins depends on the order)
+struct Bounds {
+    float min[LANES];
+    float max[LANES];
+
+    Bounds() {
+        for (size_t i = 0; i < LANES; i++) {
+            min[i] = std::numeric_limits<float>::infinity();
+            max[i] = -std::numeric_limits<float>::infinity();
+        }
+    }
+
+    void add(size_t lane, float value) {
+        min[lane] = value < min[lane] ? value : min[lane];
+        max[lane] = value > max[lane] ? value : max[lane];
+    }
+};
+
+Reductions::Extremes foldBounds(Bounds& bounds, const float* tail, size_t tailCount) {
+    for (size_t i = 0; i < tailCount; i++) {
+        bounds.add(i, tail[i]);
+    }
+    Reductions::Extremes result;
+    float min = bounds.min[0], max = bounds.max[0];
+    for (size_t i = 0; i < LANES; i++) {
+        min = bounds.min[i] < min ? bounds.min[i] : min;
+        max = bounds.max[i] > max ? bounds.max[i] : max;
+    }
+    // Only a block of nothing but NaN leaves min above max
+    if (min <= max) {
+        result.empty = false;
+        result.min = min;
+        result.max = max;
+    }
+    return result;
+}
+
+Reductions::Extremes extremesPortable(const float* data, size_t count) {
+    Bounds bounds;
+    size_t blocks = count / LANES;
+    for (size_t b = 0; b < blocks; b++) {
+        const float* p = data + b * LANES;
+        for (size_t i = 0; i < LANES; i++) {
+            bounds.add(i, p[i]);
+        }
+    }
+    return foldBounds(bounds, data + blocks * LANES, count % LANES);
+}
+
+#ifdef REDUCTIONS_X86
+
+template <bool Compensated>
+__attribute__((target("avx2"), always_inline))
+inline void kahanAVX2(__m256d& total, __m256d& comp, __m256d value) {
+    if (Compensated) {
+        __m256d y = _mm256_sub_pd(value, comp);
+        __m256d t = _mm256_add_pd(total, y);
+        comp = _mm256_sub_pd(_mm256_sub_pd(t, total), y);
+        total = t;
+    } else {
+        total = _mm256_add_pd(total, value);
+    }
+}
+
+template <bool Compensated>
+__attribute__((target("avx2")))
+Reductions::Result reduceAVX2(const float* data, size_t count, double center) {
+    Lanes lanes;
+    __m256d c = _mm256_set1_pd(center);
+    __m256 cf = _mm256_set1_ps(static_cast<float>(center));
+    int ordered = 0;
+    __m256d sum[4], sumComp[4], sq[4], sqComp[4];
+    for (int i = 0; i < 4; i++) {
+        sum[i] = _mm256_setzero_pd();
+        sumComp[i] = _mm256_setzero_pd();
+        sq[i] = _mm256_setzero_pd();
+        sqComp[i] = _mm256_setzero_pd();
+    }
+    __m256 mn[2] = {_mm256_loadu_ps(lanes.min), _mm256_loadu_ps(lanes.min + 8)};
+    __m256 mx[2] = {_mm256_loadu_ps(lanes.max), _mm256_loadu_ps(lanes.max + 8)};
+
+    size_t blocks = count / LANES;
+    for (size_t b = 0; b < blocks; b++) {
+        const float* p = data + b * LANES;
+        for (int half = 0; half < 2; half++) {
+            __m256 v = _mm256_loadu_ps(p + half * 8);
+            // min/max(v, acc) keeps acc when v is NaN, like Lanes::add
+            mn[half] = _mm256_min_ps(v, mn[half]);
+            mx[half] = _mm256_max_ps(v, mx[half]);
+            // NaNs become the center, a deviation of exactly 0
+            __m256 valid = _mm256_cmp_ps(v, v, _CMP_ORD_Q);
+            ordered += __builtin_popcount(_mm256_movemask_ps(valid));
+            v = _mm256_blendv_ps(cf, v, valid);
+            __m256d lo = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(v)), c);
+            __m256d hi = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)), c);
+            int l = half * 2, h = half * 2 + 1;
+            kahanAVX2<Compensated>(sum[l], sumComp[l], lo);
+            kahanAVX2<Compensated>(sum[h], sumComp[h], hi);
+            kahanAVX2<Compensated>(sq[l], sqComp[l], _mm256_mul_pd(lo, lo));
+            kahanAVX2<Compensated>(sq[h], sqComp[h], _mm256_mul_pd(hi, hi));
+        }
+    }
+
+    for (int i = 0; i < 4; i++) {
+        _mm256_storeu_pd(lanes.sum + i * 4, sum[i]);
+        _mm256_storeu_pd(lanes.sumComp + i * 4, sumComp[i]);
+        _mm256_storeu_pd(lanes.sumSquares + i * 4, sq[i]);
+        _mm256_storeu_pd(lanes.squaresComp + i * 4, sqComp[i]);
+    }
+    for (int i = 0; i < 2; i++) {
+        _mm256_storeu_ps(lanes.min + i * 8, mn[i]);
+        _mm256_storeu_ps(lanes.max + i * 8, mx[i]);
+    }
+    lanes.nans = blocks * LANES - ordered;
+    return fold<Compensated>(lanes, data + blocks * LANES, count % LANES, count, center);
+}
+
+template <bool Compensated>
+__attribute__((target("avx512f"), always_inline))
+inline void kahanAVX512(__m512d& total, __m512d& comp, __m512d value) {
+    if (Compensated) {
+        __m512d y = _mm512_sub_pd(value, comp);
+        __m512d t = _mm512_add_pd(total, y);
+        comp = _mm512_sub_pd(_mm512_sub_pd(t, total), y);
+        total = t;
+    } else {
+        total = _mm512_add_pd(total, value);
+    }
+}
+
+template <bool Compensated>
+__attribute__((target("avx512f")))
+Reductions::Result reduceAVX512(const float* data, size_t count, double center) {
+    Lanes lanes;
+    __m512d c = _mm512_set1_pd(center);
+    __m512 cf = _mm512_set1_ps(static_cast<float>(center));
+    size_t ordered = 0;
+    __m512d sum[2], sumComp[2], sq[2], sqComp[2];
+    for (int i = 0; i < 2; i++) {
+        sum[i] = _mm512_setzero_pd();
+        sumComp[i] = _mm512_setzero_pd();
+        sq[i] = _mm512_setzero_pd();
+        sqComp[i] = _mm512_setzero_pd();
+    }
+    __m512 mn = _mm512_loadu_ps(lanes.min);
+    __m512 mx = _mm512_loadu_ps(lanes.max);
+
+    size_t blocks = count / LANES;
+    for (size_t b = 0; b < blocks; b++) {
+        __m512 v = _mm512_loadu_ps(data + b * LANES);
+        mn = _mm512_min_ps(v, mn);
+        mx = _mm512_max_ps(v, mx);
+        // NaNs become the center, a deviation of exactly 0
+        __mmask16 valid = _mm512_cmp_ps_mask(v, v, _CMP_ORD_Q);
+        ordered += __builtin_popcount(valid);
+        v = _mm512_mask_blend_ps(valid, cf, v);
+        __m512d lo = _mm512_sub_pd(_mm512_cvtps_pd(_mm512_castps512_ps256(v)), c);
+        __m512d hi = _mm512_sub_pd(_mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1))), c);
+        kahanAVX512<Compensated>(sum[0], sumComp[0], lo);
+        kahanAVX512<Compensated>(sum[1], sumComp[1], hi);
+        kahanAVX512<Compensated>(sq[0], sqComp[0], _mm512_mul_pd(lo, lo));
+        kahanAVX512<Compensated>(sq[1], sqComp[1], _mm512_mul_pd(hi, hi));
+    }
+
+    for (int i = 0; i < 2; i++) {
+        _mm512_storeu_pd(lanes.sum + i * 8, sum[i]);
+        _mm512_storeu_pd(lanes.sumComp + i * 8, sumComp[i]);
+        _mm512_storeu_pd(lanes.sumSquares + i * 8, sq[i]);
+        _mm512_storeu_pd(lanes.squaresComp + i * 8, sqComp[i]);
+    }
+    _mm512_storeu_ps(lanes.min, mn);
+    _mm512_storeu_ps(lanes.max, mx);
+    lanes.nans = blocks * LANES - ordered;
+    return fold<Compensated>(lanes, data + blocks * LANES, count % LANES, count, center);
+}
+
+__attribute__((target("avx2")))
+Reductions::Extremes extremesAVX2(const float* data, size_t count) {
+    Bounds bounds;
+    __m256 mn[2] = {_mm256_loadu_ps(bounds.min), _mm256_loadu_ps(bounds.min + 8)};
+    __m256 mx[2] = {_mm256_loadu_ps(bounds.max), _mm256_loadu_ps(bounds.max + 8)};
+    size_t blocks = count / LANES;
+    for (size_t b = 0; b < blocks; b++) {
+        const float* p = data + b * LANES;
+        for (int half = 0; half < 2; half++) {
+            __m256 v = _mm256_loadu_ps(p + half * 8);
+            mn[half] = _mm256_min_ps(v, mn[half]);
+            mx[half] = _mm256_max_ps(v, mx[half]);
+        }
+    }
+    for (int i = 0; i < 2; i++) {
+        _mm256_storeu_ps(bounds.min + i * 8, mn[i]);
+        _mm256_storeu_ps(bounds.max + i * 8, mx[i]);
+    }
+    return foldBounds(bounds, data + blocks * LANES, count % LANES);
+}
+
+__attribute__((target("avx512f")))
+Reductions::Extremes extremesAVX512(const float* data, size_t count) {
+    Bounds bounds;
+    __m512 mn = _mm512_loadu_ps(bounds.min);
+    __m512 mx = _mm512_loadu_ps(bounds.max);
+    size_t blocks = count / LANES;
+    for (size_t b = 0; b < blocks; b++) {
+        __m512 v = _mm512_loadu_ps(data + b * LANES);
+        mn = _mm512_min_ps(v, mn);
+        mx = _mm512_max_ps(v, mx);
+    }
+    _mm512_storeu_ps(bounds.min, mn);
+    _mm512_storeu_ps(bounds.max, mx);
+    return foldBounds(bounds, data + blocks * LANES, count % LANES);
+}
+
+#endif
+
+Reductions::Extremes extremesBlock(const float* data, size_t count, Reductions::Kernel kernel) {
+#ifdef REDUCTIONS_X86
+    if (kernel == Reductions::Kernel::AVX512) return extremesAVX512(data, count);
+    if (kernel == Reductions::Kernel::AVX2) return extremesAVX2(data, count);
+#else
+    (void)kernel;
+#endif
+    return extremesPortable(data, count);
+}
+
+template <bool Compensated>
+Reductions::Result reduceBlock(const float* data, size_t count, Reductions::Kernel kernel) {
+    // Any finite value of the block will do as the center
+    double center = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        if (std::isfinite(data[i])) {
+            center = data[i];
+            break;
+        }
+    }
+#ifdef REDUCTIONS_X86
+    if (kernel == Reductions::Kernel::AVX512) return reduceAVX512<Compensated>(data, count, center);
+    if (kernel == Reductions::Kernel::AVX2) return reduceAVX2<Compensated>(data, count, center);
+#else
+    (void)kernel;
+#endif
+    return reducePortable<Compensated>(data, count, center);
+}
+
+template <bool Compensated>
+Reductions::Result dispatch(const float* data, size_t count, Reductions::Kernel kernel) {
+    if (count <= Reductions::BLOCK_VALUES) {
+        return reduceBlock<Compensated>(data, count, kernel);
+    }
+    Reductions::Combiner combined;
+    for (size_t first = 0; first < count; first += Reductions::BLOCK_VALUES) {
+        combined.add(reduceBlock<Compensated>(data + first, std::min(Reductions::BLOCK_VALUES, count - first), kernel));
+    }
+    return combined.value();
+}
+
+Reductions::Kernel detectKernel() {
+#ifdef REDUCTIONS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return Reductions::Kernel::AVX512;
+    if (__builtin_cpu_supports("avx2")) return Reductions::Kernel::AVX2;
+#endif
+    return Reductions::Kernel::Portable;
+}
+
+}
+
+void Reductions::Accumulator::add(double value) {
+    double t = sum + value;
+    if (std::fabs(sum) >= std::fabs(value)) {
+        compensation += (sum - t) + value;
+    } else {
+        compensation += (value - t) + sum;
+    }
+    sum = t;
+}
+
+double Reductions::Accumulator::value() const {
+    return sum + compensation;
+}
+
+double Reductions::Result::mean() const {
+    return count > 0 ? sum / count : 0.0;
+}
+
+double Reductions::Result::variance() const {
+    return count > 0 ? m2 / count : 0.0;
+}
+
+void Reductions::Combiner::add(const Result& part) {
+    if (part.count == 0) return;
+    if (result.count == 0) {
+        result = part;
+        sum = Accumulator();
+        sum.add(part.sum);
+        return;
+    }
+    // Chan et al. pairwise combination, as in Analyzer::FieldStats::merge
+    size_t total = result.count + part.count;
+    double delta = part.mean() - sum.value() / result.count;
+    result.m2 += part.m2 + delta * delta * (static_cast<double>(result.count) * part.count / total);
+    result.min = part.min < result.min ? part.min : result.min;
+    result.max = part.max > result.max ? part.max : result.max;
+    result.count = total;
+    sum.add(part.sum);
+}
+
+void Reductions::Extremes::add(const Extremes& part) {
+    if (part.empty) return;
+    if (empty) {
+        *this = part;
+        return;
+    }
+    min = part.min < min ? part.min : min;
+    max = part.max > max ? part.max : max;
+}
+
+Reductions::Result Reductions::Combiner::value() const {
+    Result combined = result;
+    combined.sum = sum.value();
+    return combined;
+}
+
+Reductions::Kernel Reductions::bestKernel() {
+    static const Kernel kernel = detectKernel();
+    return kernel;
+}
+
+const char* Reductions::kernelName(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::AVX2: return "AVX2";
+        case Kernel::AVX512: return "AVX-512";
+        default: return "Portable";
+    }
+}
+
+Reductions::Result Reductions::reduce(std::span<const float> values, Summation summation) {
+    return reduce(values, bestKernel(), summation);
+}
+
+Reductions::Result Reductions::reduce(std::span<const float> values, Kernel kernel, Summation summation) {
+    // Never run a kernel the CPU cannot execute, whatever the caller asked for
+    if (kernel > bestKernel()) kernel = bestKernel();
+
+    if (summation == Summation::Compensated) {
+        return dispatch<true>(values.data(), values.size(), kernel);
+    }
+    return dispatch<false>(values.data(), values.size(), kernel);
+}
+
+Reductions::Extremes Reductions::extremes(std::span<const float> values) {
+    return extremes(values, bestKernel());
+}
+
+Reductions::Extremes Reductions::extremes(std::span<const float> values, Kernel kernel) {
+    if (kernel > bestKernel()) kernel = bestKernel();
+
+    // Block by block like reduce(), so ties between -0 and +0 go the same way
+    Extremes combined;
+    for (size_t first = 0; first < values.size(); first += BLOCK_VALUES) {
+        combined.add(extremesBlock(values.data() + first, std::min(BLOCK_VALUES, values.size() - first), kernel));
+    }
+    return combined;
+}
+
+double Reductions::sum(std::span<const float> values) { return reduce(values).sum; }
+double Reductions::variance(std::span<const float> values) { return reduce(values).variance(); }
+float Reductions::min(std::span<const float> values) { return extremes(values).min; }
+float Reductions::max(std::span<const float> values) { return extremes(values).max; }
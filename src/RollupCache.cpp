@@ -0,0 +1,129 @@
+#include "RollupCache.h"
+#include "Timestamp.h"
+#include <algorithm>
+
+int64_t RollupCache::bucketStart(int64_t timestamp, Level level) {
+    switch (level) {
+        case Level::Hour: return Analyzer::bucketStart(timestamp, Analyzer::Bucket::Hour);
+        case Level::Day: return Analyzer::bucketStart(timestamp, Analyzer::Bucket::Day);
+        default: return Timestamp::startOfMonth(timestamp);
+    }
+}
+
+int64_t RollupCache::bucketEnd(int64_t start, Level level) {
+    switch (level) {
+        case Level::Hour: return start + Timestamp::MINUTES_PER_HOUR;
+        case Level::Day: return start + Timestamp::MINUTES_PER_DAY;
+        // 31 days past the first of any month is inside the next one
+        default: return Timestamp::startOfMonth(start + 31 * Timestamp::MINUTES_PER_DAY);
+    }
+}
+
+void RollupCache::clear() {
+    for (int level = 0; level < LEVEL_COUNT; level++) {
+        levels[level].clear();
+    }
+}
+
+void RollupCache::rebuild(const TimeRange& series) {
+    clear();
+    // Hours from the rows, then each level from the one below it; input is
+    // sorted, so every insert goes at the end of its map
+    Buckets& hours = levels[0];
+    for (const Measurement& m : series) {
+        int64_t start = bucketStart(m.getTimestamp(), Level::Hour);
+        if (hours.empty() || std::prev(hours.end())->first != start) {
+            hours.emplace_hint(hours.end(), start, Analyzer::Summary());
+        }
+        std::prev(hours.end())->second.add(m);
+    }
+    for (int level = 1; level < LEVEL_COUNT; level++) {
+        Buckets& coarse = levels[level];
+        for (const auto& entry : levels[level - 1]) {
+            int64_t start = bucketStart(entry.first, static_cast<Level>(level));
+            if (coarse.empty() || std::prev(coarse.end())->first != start) {
+                coarse.emplace_hint(coarse.end(), start, Analyzer::Summary());
+            }
+            std::prev(coarse.end())->second.merge(entry.second);
+        }
+    }
+}
+
+void RollupCache::add(const Measurement& m) {
+    for (int level = 0; level < LEVEL_COUNT; level++) {
+        levels[level][bucketStart(m.getTimestamp(), static_cast<Level>(level))].add(m);
+    }
+}
+
+void RollupCache::store(int level, int64_t start, const Analyzer::Summary& summary) {
+    if (summary.count() == 0) {
+        levels[level].erase(start);
+    } else {
+        levels[level][start] = summary;
+    }
+}
+
+void RollupCache::refresh(int64_t timestamp, const TimeRange& hourRows) {
+    // Welford state cannot subtract a sample (nor restore a min or max), so
+    // the hour is summed again from its rows and the coarser buckets from
+    // their children: at most 24 + 31 merges
+    Analyzer::Summary hour;
+    for (const Measurement& m : hourRows) {
+        hour.add(m);
+    }
+    store(0, bucketStart(timestamp, Level::Hour), hour);
+
+    for (int level = 1; level < LEVEL_COUNT; level++) {
+        Level coarse = static_cast<Level>(level);
+        int64_t start = bucketStart(timestamp, coarse);
+        const Buckets& finer = levels[level - 1];
+        Analyzer::Summary summary;
+        auto last = finer.lower_bound(bucketEnd(start, coarse));
+        for (auto it = finer.lower_bound(start); it != last; ++it) {
+            summary.merge(it->second);
+        }
+        store(level, start, summary);
+    }
+}
+
+const RollupCache::Buckets& RollupCache::buckets(Level level) const {
+    return levels[static_cast<int>(level)];
+}
+
+Analyzer::Summary RollupCache::query(int64_t from, int64_t to, const TimeIndex& index,
+                                     const std::vector<Measurement>& measurements) const {
+    Analyzer::Summary summary;
+    const Buckets& hours = levels[0];
+    if (hours.empty()) return summary;
+
+    // Nothing to find outside the stored hours, so open-ended windows stay cheap
+    from = std::max(from, hours.begin()->first);
+    to = std::min(to, std::prev(hours.end())->first + Timestamp::MINUTES_PER_HOUR);
+
+    int64_t cursor = from;
+    while (cursor < to) {
+        // The coarsest bucket that starts here and fits in the window
+        int level = LEVEL_COUNT - 1;
+        for (; level >= 0; level--) {
+            Level candidate = static_cast<Level>(level);
+            if (bucketStart(cursor, candidate) == cursor && bucketEnd(cursor, candidate) <= to) break;
+        }
+
+        if (level < 0) {
+            // Partial hour at either end of the window
+            int64_t end = std::min(bucketEnd(bucketStart(cursor, Level::Hour), Level::Hour), to);
+            for (const Measurement& m : index.range(cursor, end, measurements)) {
+                summary.add(m);
+            }
+            cursor = end;
+            continue;
+        }
+
+        auto it = levels[level].find(cursor);
+        if (it != levels[level].end()) {
+            summary.merge(it->second);
+        }
+        cursor = bucketEnd(cursor, static_cast<Level>(level));
+    }
+    return summary;
+}
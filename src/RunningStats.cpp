@@ -0,0 +1,105 @@
+#include "RunningStats.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+void RunningStats::Field::addMoments(float value) {
+    count++;
+    double delta = value - mean;
+    mean += delta / count;
+    m2 += delta * (value - mean);
+}
+
+void RunningStats::Field::add(float value) {
+    if (std::isnan(value)) return;
+
+    addMoments(value);
+    values[value]++;
+}
+
+void RunningStats::Field::rebuild(const std::vector<Measurement>& measurements, float (Measurement::*get)() const) {
+    *this = Field();
+    // Counting in a hash map first leaves the ordered map one insert per
+    // distinct value, all at its end
+    std::unordered_map<float, size_t> counts;
+    for (const Measurement& m : measurements) {
+        float value = (m.*get)();
+        if (std::isnan(value)) continue;
+        addMoments(value);
+        counts[value]++;
+    }
+    std::vector<std::pair<float, size_t>> sorted(counts.begin(), counts.end());
+    std::sort(sorted.begin(), sorted.end());
+    for (const auto& entry : sorted) {
+        values.emplace_hint(values.end(), entry.first, entry.second);
+    }
+}
+
+void RunningStats::Field::remove(float value) {
+    if (std::isnan(value)) return;
+
+    auto it = values.find(value);
+    if (it == values.end()) return;
+    if (--it->second == 0) {
+        values.erase(it);
+    }
+
+    if (count == 1) {
+        count = 0;
+        mean = 0.0;
+        m2 = 0.0;
+        return;
+    }
+    // Welford's update run backwards
+    double delta = value - mean;
+    mean -= delta / (count - 1);
+    m2 -= delta * (value - mean);
+    if (m2 < 0.0) m2 = 0.0;
+    count--;
+}
+
+Analyzer::FieldStats RunningStats::Field::stats() const {
+    Analyzer::FieldStats stats;
+    stats.count = count;
+    if (count == 0) return stats;
+    stats.mean = mean;
+    stats.m2 = m2;
+    stats.min = values.begin()->first;
+    stats.max = values.rbegin()->first;
+    return stats;
+}
+
+void RunningStats::add(const Measurement& m) {
+    temperature.add(m.getTemperature());
+    humidity.add(m.getHumidity());
+    windSpeed.add(m.getWindSpeed());
+}
+
+void RunningStats::remove(const Measurement& m) {
+    temperature.remove(m.getTemperature());
+    humidity.remove(m.getHumidity());
+    windSpeed.remove(m.getWindSpeed());
+}
+
+void RunningStats::clear() {
+    temperature = Field();
+    humidity = Field();
+    windSpeed = Field();
+}
+
+void RunningStats::rebuild(const std::vector<Measurement>& measurements) {
+    // The fields are independent of each other
+    Field* fields[] = {&temperature, &humidity, &windSpeed};
+    float (Measurement::*getters[])() const = {&Measurement::getTemperature, &Measurement::getHumidity,
+                                               &Measurement::getWindSpeed};
+    ThreadPool::shared().parallelFor(3, [&](size_t f) { fields[f]->rebuild(measurements, getters[f]); });
+}
+
+Analyzer::Summary RunningStats::summary() const {
+    Analyzer::Summary summary;
+    summary.temperature = temperature.stats();
+    summary.humidity = humidity.stats();
+    summary.windSpeed = windSpeed.stats();
+    return summary;
+}
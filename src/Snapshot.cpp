@@ -0,0 +1,198 @@
+#include "Snapshot.h"
+#include "Crc32.h"
+#include "FileSync.h"
+#include "MappedFile.h"
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+static_assert(std::endian::native == std::endian::little, "snapshot columns are stored little-endian");
+
+namespace {
+
+const char MAGIC[8] = {'\x89', 'W', 'S', 'N', 'A', 'P', '\r', '\n'};
+const size_t ALIGNMENT = 64;
+
+enum ColumnKind : uint32_t {
+    TIMESTAMPS = 1,
+    IDS = 2,
+    TEMPERATURES = 3,
+    HUMIDITIES = 4,
+    WIND_SPEEDS = 5
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t columnCount;
+    uint64_t rowCount;
+    uint64_t sequence;
+    uint32_t crc;           // header with crc = 0, followed by the directory
+    uint32_t reserved;
+};
+
+struct ColumnEntry {
+    uint32_t kind;
+    uint32_t elementSize;
+    uint64_t offset;
+    uint64_t bytes;
+    uint32_t crc;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(Header) == 40 && sizeof(ColumnEntry) == 32, "snapshot layout changed");
+
+const int COLUMN_COUNT = 5;
+
+struct ColumnData {
+    ColumnKind kind;
+    uint32_t elementSize;
+    const void* data;
+};
+
+uint64_t alignUp(uint64_t offset) {
+    return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+uint32_t headerChecksum(Header header, const ColumnEntry* directory, uint32_t columnCount) {
+    header.crc = 0;
+    uint32_t crc = Crc32::compute(&header, sizeof(header));
+    return Crc32::compute(directory, columnCount * sizeof(ColumnEntry), crc);
+}
+
+// Finds and verifies one column; out receives rowCount elements
+template <typename T>
+bool readColumn(const char* begin, size_t size, const ColumnEntry* directory, uint32_t columnCount,
+                ColumnKind kind, uint64_t rowCount, std::vector<T>& out) {
+    for (uint32_t i = 0; i < columnCount; i++) {
+        const ColumnEntry& entry = directory[i];
+        if (entry.kind != kind) continue;
+        if (entry.elementSize != sizeof(T) || entry.bytes != rowCount * sizeof(T) ||
+            entry.offset > size || entry.bytes > size - entry.offset) {
+            return false;
+        }
+        const char* data = begin + entry.offset;
+        if (Crc32::compute(data, entry.bytes) != entry.crc) {
+            return false;
+        }
+        out.resize(rowCount);
+        std::memcpy(out.data(), data, entry.bytes);
+        return true;
+    }
+    return false;
+}
+
+}
+
+bool Snapshot::isSnapshot(const char* begin, const char* end) {
+    return static_cast<size_t>(end - begin) >= sizeof(MAGIC) && std::memcmp(begin, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+bool Snapshot::isSnapshotFile(const std::string& filename) {
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    char magic[sizeof(MAGIC)];
+    if (!file.read(magic, sizeof(magic))) {
+        return false;
+    }
+    return isSnapshot(magic, magic + sizeof(magic));
+}
+
+bool Snapshot::save(const std::string& filename, const MeasurementColumns& columns, uint64_t sequence) {
+    const ColumnData sources[COLUMN_COUNT] = {
+        {TIMESTAMPS, sizeof(int64_t), columns.getTimestamps().data()},
+        {IDS, sizeof(int), columns.getIds().data()},
+        {TEMPERATURES, sizeof(float), columns.getTemperatures().data()},
+        {HUMIDITIES, sizeof(float), columns.getHumidities().data()},
+        {WIND_SPEEDS, sizeof(float), columns.getWindSpeeds().data()},
+    };
+
+    Header header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.columnCount = COLUMN_COUNT;
+    header.rowCount = columns.size();
+    header.sequence = sequence;
+
+    ColumnEntry directory[COLUMN_COUNT] = {};
+    uint64_t offset = alignUp(sizeof(Header) + sizeof(directory));
+    for (int i = 0; i < COLUMN_COUNT; i++) {
+        directory[i].kind = sources[i].kind;
+        directory[i].elementSize = sources[i].elementSize;
+        directory[i].offset = offset;
+        directory[i].bytes = header.rowCount * sources[i].elementSize;
+        directory[i].crc = Crc32::compute(sources[i].data, directory[i].bytes);
+        offset = alignUp(offset + directory[i].bytes);
+    }
+    header.crc = headerChecksum(header, directory, COLUMN_COUNT);
+
+    std::string temporary = filename + ".tmp";
+    std::ofstream file(temporary.c_str(), std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    const char padding[ALIGNMENT] = {};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(directory), sizeof(directory));
+    uint64_t written = sizeof(header) + sizeof(directory);
+    for (int i = 0; i < COLUMN_COUNT; i++) {
+        file.write(padding, directory[i].offset - written);
+        file.write(static_cast<const char*>(sources[i].data), directory[i].bytes);
+        written = directory[i].offset + directory[i].bytes;
+    }
+    file.close();
+    if (!file) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+
+    // A failed replace keeps both the old snapshot and the new one's .tmp
+    return FileSync::replace(temporary, filename);
+}
+
+bool Snapshot::load(const char* begin, const char* end, MeasurementColumns& columns, uint64_t* sequence) {
+    size_t size = end - begin;
+    if (size < sizeof(Header) || !isSnapshot(begin, end)) {
+        return false;
+    }
+    Header header;
+    std::memcpy(&header, begin, sizeof(header));
+    if (header.version == 0 || header.version > VERSION || header.columnCount == 0 ||
+        header.columnCount > (size - sizeof(Header)) / sizeof(ColumnEntry)) {
+        return false;
+    }
+    std::vector<ColumnEntry> directory(header.columnCount);
+    std::memcpy(directory.data(), begin + sizeof(Header), header.columnCount * sizeof(ColumnEntry));
+    if (headerChecksum(header, directory.data(), header.columnCount) != header.crc) {
+        return false;
+    }
+
+    std::vector<int64_t> timestamps;
+    std::vector<int> ids;
+    std::vector<float> temperatures, humidities, windSpeeds;
+    const ColumnEntry* entries = directory.data();
+    uint64_t rows = header.rowCount;
+    if (!readColumn(begin, size, entries, header.columnCount, TIMESTAMPS, rows, timestamps) ||
+        !readColumn(begin, size, entries, header.columnCount, IDS, rows, ids) ||
+        !readColumn(begin, size, entries, header.columnCount, TEMPERATURES, rows, temperatures) ||
+        !readColumn(begin, size, entries, header.columnCount, HUMIDITIES, rows, humidities) ||
+        !readColumn(begin, size, entries, header.columnCount, WIND_SPEEDS, rows, windSpeeds)) {
+        return false;
+    }
+
+    columns.assign(std::move(ids), std::move(temperatures), std::move(humidities), std::move(windSpeeds),
+                   std::move(timestamps));
+    if (sequence != nullptr) {
+        *sequence = header.sequence;
+    }
+    return true;
+}
+
+bool Snapshot::load(const std::string& filename, MeasurementColumns& columns, uint64_t* sequence) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        return false;
+    }
+    return load(file.begin(), file.end(), columns, sequence);
+}
@@ -0,0 +1,209 @@
+#include "TailFollower.h"
+#include "MeasurementParser.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+// What the path names right now. Windows has no cheap file identity, so
+// there only truncation is noticed, not rotation.
+bool identify(const std::string& path, uint64_t& id, uint64_t& size) {
+#ifdef _WIN32
+    std::error_code error;
+    size = std::filesystem::file_size(path, error);
+    id = 0;
+    return !error;
+#else
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return false;
+    }
+    size = static_cast<uint64_t>(info.st_size);
+    id = static_cast<uint64_t>(info.st_ino);
+    return true;
+#endif
+}
+
+}
+
+TailFollower::~TailFollower() {
+    close();
+}
+
+bool TailFollower::open(const std::string& filename, uint64_t startOffset) {
+    close();
+    path = filename;
+    if (!reopen()) {
+        path.clear();
+        return false;
+    }
+    offset = startOffset;
+
+#ifdef __linux__
+    // Watch the directory rather than the file, so a rotated-in file with
+    // the same name still wakes wait()
+    notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notifyFd >= 0) {
+        std::string directory = std::filesystem::path(filename).parent_path().string();
+        uint32_t events = IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE;
+        if (inotify_add_watch(notifyFd, directory.empty() ? "." : directory.c_str(), events) < 0) {
+            ::close(notifyFd);
+            notifyFd = -1;
+        }
+    }
+#endif
+    return true;
+}
+
+// Opens whatever path names now, from byte 0
+bool TailFollower::reopen() {
+    file.close();
+    file.clear();
+    offset = 0;
+    carry.clear();
+    // Identify before and after opening so a rotation in between is not
+    // mistaken for the file that was opened
+    for (int attempt = 0; attempt < 3; attempt++) {
+        uint64_t before, after, size;
+        if (!identify(path, before, size)) {
+            return false;
+        }
+        file.open(path.c_str(), std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        if (identify(path, after, size) && after == before) {
+            fileId = after;
+            return true;
+        }
+        file.close();
+        file.clear();
+    }
+    return false;
+}
+
+void TailFollower::close() {
+    file.close();
+    file.clear();
+    path.clear();
+    offset = 0;
+    carry.clear();
+    fileId = 0;
+#ifdef __linux__
+    if (notifyFd >= 0) {
+        ::close(notifyFd);
+        notifyFd = -1;
+    }
+#endif
+}
+
+bool TailFollower::isOpen() const {
+    return !path.empty();
+}
+
+size_t TailFollower::poll(WeatherStation& station) {
+    if (path.empty()) {
+        return 0;
+    }
+    // Everything new goes to the station in one batch
+    std::vector<Measurement> parsed;
+    uint64_t id, size;
+    if (!identify(path, id, size)) {
+        // Moved away and the replacement is not there yet
+        if (file.is_open()) {
+            readAppended(parsed);
+        }
+    } else if (!file.is_open()) {
+        if (reopen()) {
+            readAppended(parsed);
+        }
+    } else if (id == fileId && size < offset + carry.size()) {
+        // Truncated in place: start over, dropping the unfinished line
+        offset = 0;
+        carry.clear();
+        readAppended(parsed);
+    } else {
+        readAppended(parsed);
+        if (id != fileId) {
+            // Rotated: the old file is finished, so its last line is complete
+            // even without a newline
+            MeasurementParser::parseBuffer(carry.data(), carry.data() + carry.size(), parsed);
+            if (reopen()) {
+                readAppended(parsed);
+            }
+        }
+    }
+    station.addMeasurements(parsed);
+    return parsed.size();
+}
+
+void TailFollower::readAppended(std::vector<Measurement>& parsed) {
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(offset + carry.size()));
+    while (file) {
+        size_t kept = carry.size();
+        carry.resize(kept + READ_BYTES);
+        file.read(&carry[kept], READ_BYTES);
+        carry.resize(kept + static_cast<size_t>(file.gcount()));
+
+        size_t lineEnd = carry.rfind('\n');
+        if (carry.size() == kept || lineEnd == std::string::npos) {
+            continue;
+        }
+        MeasurementParser::parseBuffer(carry.data(), carry.data() + lineEnd + 1, parsed);
+        offset += lineEnd + 1;
+        carry.erase(0, lineEnd + 1);
+    }
+    // Leave the stream usable for the next poll
+    file.clear();
+}
+
+bool TailFollower::wait(int timeoutMs) {
+#ifdef __linux__
+    if (notifyFd >= 0) {
+        std::string name = std::filesystem::path(path).filename().string();
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        alignas(inotify_event) char buffer[4096];
+        while (true) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            pollfd ready = {notifyFd, POLLIN, 0};
+            if (::poll(&ready, 1, static_cast<int>(std::max<int64_t>(left.count(), 0))) <= 0) {
+                return false;
+            }
+            // Other files in the directory wake us too; only ours counts
+            bool ours = false;
+            ssize_t bytes;
+            while ((bytes = read(notifyFd, buffer, sizeof(buffer))) > 0) {
+                for (char* p = buffer; p < buffer + bytes;) {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+                    if ((event->mask & IN_Q_OVERFLOW) || (event->len > 0 && name == event->name)) {
+                        ours = true;
+                    }
+                    p += sizeof(inotify_event) + event->len;
+                }
+            }
+            if (ours) {
+                return true;
+            }
+        }
+    }
+#endif
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+    return true;
+}
+
+uint64_t TailFollower::getOffset() const {
+    return offset;
+}
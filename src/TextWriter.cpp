@@ -0,0 +1,43 @@
+#include "TextWriter.h"
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+#ifdef _WIN32
+const char LINE_END[] = "\r\n";
+#else
+const char LINE_END[] = "\n";
+#endif
+const size_t LINE_END_BYTES = sizeof(LINE_END) - 1;
+
+}
+
+bool TextWriter::write(const std::string& filename, std::span<const Measurement> rows) {
+    // Binary mode: the line ending is written explicitly, so the C library
+    // has nothing to translate and the buffer goes out as-is
+    FILE* file = std::fopen(filename.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    std::setvbuf(file, nullptr, _IONBF, 0);
+
+    std::vector<char> buffer(CHUNK_BYTES + Measurement::MAX_TEXT_LINE + LINE_END_BYTES);
+    char* begin = buffer.data();
+    char* out = begin;
+    bool ok = true;
+    for (const Measurement& m : rows) {
+        out = m.formatTextLine(out);
+        for (size_t i = 0; i < LINE_END_BYTES; i++) {
+            *out++ = LINE_END[i];
+        }
+        if (static_cast<size_t>(out - begin) >= CHUNK_BYTES) {
+            ok = ok && std::fwrite(begin, 1, out - begin, file) == static_cast<size_t>(out - begin);
+            out = begin;
+        }
+    }
+    if (out != begin) {
+        ok = ok && std::fwrite(begin, 1, out - begin, file) == static_cast<size_t>(out - begin);
+    }
+    return std::fclose(file) == 0 && ok;
+}
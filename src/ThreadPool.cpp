@@ -0,0 +1,127 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threadCount) : nextQueue(0), pending(0), stopping(false) {
+    if (threadCount == 0) {
+        unsigned hardware = std::thread::hardware_concurrency();
+        threadCount = hardware > 1 ? hardware - 1 : 1;
+    }
+    for (unsigned i = 0; i < threadCount; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned i = 0; i < threadCount; i++) {
+        threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+size_t ThreadPool::size() const {
+    return threads.size();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    Queue& queue = *queues[nextQueue++ % queues.size()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        pending++;
+    }
+    wake.notify_one();
+}
+
+// Runs one task: the newest from queue first, else the oldest from any other
+bool ThreadPool::runOne(size_t first) {
+    std::function<void()> task;
+    for (size_t i = 0; i < queues.size() && !task; i++) {
+        Queue& queue = *queues[(first + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+        if (i == 0) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+    }
+    if (!task) {
+        return false;
+    }
+    pending--;
+    task();
+    return true;
+}
+
+void ThreadPool::workerLoop(size_t self) {
+    while (true) {
+        if (runOne(self)) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this]() { return stopping || pending > 0; });
+        if (stopping && pending == 0) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& body) {
+    if (count == 0) return;
+    if (count == 1) {
+        body(0);
+        return;
+    }
+
+    struct Batch {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> running{0};
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    auto batch = std::make_shared<Batch>();
+    auto drain = [batch, count, &body]() {
+        for (size_t i = batch->next++; i < count; i = batch->next++) {
+            body(i);
+        }
+    };
+
+    // One helper per worker at most; each pulls indices until none are left
+    size_t helpers = std::min(count - 1, size());
+    batch->running = helpers;
+    for (size_t h = 0; h < helpers; h++) {
+        submit([batch, drain]() {
+            drain();
+            if (--batch->running == 0) {
+                std::lock_guard<std::mutex> lock(batch->mutex);
+                batch->done.notify_all();
+            }
+        });
+    }
+
+    drain();
+
+    // Helpers still queued behind other work would finish instantly; run
+    // them here rather than wait for a worker to get to them
+    while (batch->running > 0) {
+        if (runOne(nextQueue % queues.size())) continue;
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->done.wait(lock, [&batch]() { return batch->running == 0; });
+    }
+}
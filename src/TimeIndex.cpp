@@ -0,0 +1,111 @@
+#include "TimeIndex.h"
+#include <algorithm>
+
+namespace {
+
+bool earlier(const TimeRange::Entry& a, const TimeRange::Entry& b) {
+    return a.timestamp < b.timestamp;
+}
+
+// Stable LSD radix sort on the timestamp, 11 bits per pass. Timestamps are
+// minutes, so a decade of data is three passes.
+void radixSort(std::vector<TimeRange::Entry>& entries) {
+    const int DIGIT_BITS = 11;
+    const size_t BUCKETS = size_t(1) << DIGIT_BITS;
+    auto [lo, hi] = std::minmax_element(entries.begin(), entries.end(), earlier);
+    int64_t base = lo->timestamp;
+    uint64_t span = static_cast<uint64_t>(hi->timestamp) - static_cast<uint64_t>(base);
+
+    std::vector<TimeRange::Entry> buffer(entries.size());
+    std::vector<size_t> offsets(BUCKETS);
+    for (int shift = 0; shift < 64 && (span >> shift) != 0; shift += DIGIT_BITS) {
+        auto digit = [&](const TimeRange::Entry& e) {
+            return ((static_cast<uint64_t>(e.timestamp) - static_cast<uint64_t>(base)) >> shift) & (BUCKETS - 1);
+        };
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (const TimeRange::Entry& e : entries) offsets[digit(e)]++;
+        size_t total = 0;
+        for (size_t& offset : offsets) {
+            size_t count = offset;
+            offset = total;
+            total += count;
+        }
+        for (const TimeRange::Entry& e : entries) buffer[offsets[digit(e)]++] = e;
+        entries.swap(buffer);
+    }
+}
+
+}
+
+TimeRange::TimeRange(const Entry* first, const Entry* last, const Measurement* rows)
+    : first(first), last(last), rows(rows) {}
+
+TimeRange::iterator TimeRange::begin() const { return iterator(first, rows); }
+TimeRange::iterator TimeRange::end() const { return iterator(last, rows); }
+size_t TimeRange::size() const { return last - first; }
+bool TimeRange::empty() const { return first == last; }
+const Measurement& TimeRange::operator[](size_t i) const { return rows[first[i].slot]; }
+
+void TimeIndex::clear() {
+    entries.clear();
+}
+
+void TimeIndex::rebuild(const std::vector<Measurement>& measurements) {
+    entries.resize(measurements.size());
+    for (size_t i = 0; i < measurements.size(); i++) {
+        entries[i] = {measurements[i].getTimestamp(), i};
+    }
+    // Archive files are usually already in time order, which is O(n) to check
+    if (!std::is_sorted(entries.begin(), entries.end(), earlier)) {
+        radixSort(entries);
+    }
+}
+
+size_t TimeIndex::insert(int64_t timestamp, size_t slot) {
+    TimeRange::Entry entry = {timestamp, slot};
+    if (entries.empty() || entries.back().timestamp <= timestamp) {
+        entries.push_back(entry);
+        return entries.size() - 1;
+    }
+    auto it = entries.insert(std::upper_bound(entries.begin(), entries.end(), entry, earlier), entry);
+    return it - entries.begin();
+}
+
+std::vector<TimeRange::Entry>::iterator TimeIndex::find(int64_t timestamp, size_t slot) {
+    TimeRange::Entry key = {timestamp, 0};
+    auto it = std::lower_bound(entries.begin(), entries.end(), key, earlier);
+    while (it != entries.end() && it->timestamp == timestamp) {
+        if (it->slot == slot) return it;
+        ++it;
+    }
+    return entries.end();
+}
+
+void TimeIndex::remove(int64_t timestamp, size_t slot) {
+    auto it = find(timestamp, slot);
+    if (it != entries.end()) {
+        entries.erase(it);
+    }
+    for (TimeRange::Entry& entry : entries) {
+        if (entry.slot > slot) {
+            entry.slot--;
+        }
+    }
+}
+
+TimeRange TimeIndex::range(int64_t from, int64_t to, const std::vector<Measurement>& measurements) const {
+    std::pair<size_t, size_t> window = bounds(from, to);
+    return TimeRange(entries.data() + window.first, entries.data() + window.second, measurements.data());
+}
+
+std::pair<size_t, size_t> TimeIndex::bounds(int64_t from, int64_t to) const {
+    TimeRange::Entry lo = {from, 0};
+    TimeRange::Entry hi = {to, 0};
+    auto first = std::lower_bound(entries.begin(), entries.end(), lo, earlier);
+    auto last = from < to ? std::lower_bound(first, entries.end(), hi, earlier) : first;
+    return {static_cast<size_t>(first - entries.begin()), static_cast<size_t>(last - entries.begin())};
+}
+
+size_t TimeIndex::size() const {
+    return entries.size();
+}
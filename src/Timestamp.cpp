@@ -0,0 +1,168 @@
+#include "Timestamp.h"
+
+namespace {
+
+// Floor division, so dates before 1970 land on the right day
+int64_t floorDiv(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant's algorithm)
+int64_t daysFromCivil(int64_t y, int m, int d) {
+    y -= m <= 2;
+    int64_t era = floorDiv(y, 400);
+    int64_t yoe = y - era * 400;
+    int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+int daysInMonth(int year, int month) {
+    static const int DAYS[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return month == 2 && leap ? 29 : DAYS[month - 1];
+}
+
+void civilFromDays(int64_t z, int& year, int& month, int& day) {
+    z += 719468;
+    int64_t era = floorDiv(z, 146097);
+    int64_t doe = z - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    day = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    year = static_cast<int>(yoe + era * 400 + (month <= 2));
+}
+
+// Reads exactly digits decimal digits, so only the canonical form parses
+// and formatting the result gives back the same text
+bool readNumber(const char*& p, const char* end, int digits, int& value) {
+    value = 0;
+    for (int i = 0; i < digits; i++) {
+        if (p == end || *p < '0' || *p > '9') {
+            return false;
+        }
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+    return true;
+}
+
+bool expect(const char*& p, const char* end, char c) {
+    if (p < end && *p == c) {
+        p++;
+        return true;
+    }
+    return false;
+}
+
+void writeDigits(char* out, int value, int width) {
+    for (int i = width - 1; i >= 0; i--) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+}
+
+}
+
+int64_t Timestamp::fromCivil(int year, int month, int day, int hour, int minute) {
+    return daysFromCivil(year, month, day) * MINUTES_PER_DAY + hour * MINUTES_PER_HOUR + minute;
+}
+
+void Timestamp::toCivil(int64_t minutes, int& year, int& month, int& day, int& hour, int& minute) {
+    civilFromDays(dayNumber(minutes), year, month, day);
+    int inDay = minuteOfDay(minutes);
+    hour = inDay / 60;
+    minute = inDay % 60;
+}
+
+int64_t Timestamp::dayNumber(int64_t minutes) {
+    return floorDiv(minutes, MINUTES_PER_DAY);
+}
+
+int Timestamp::minuteOfDay(int64_t minutes) {
+    return static_cast<int>(minutes - dayNumber(minutes) * MINUTES_PER_DAY);
+}
+
+int64_t Timestamp::startOfWeek(int64_t minutes) {
+    // Day 0 (01/01/1970) was a Thursday, three days after a Monday
+    int64_t monday = floorDiv(dayNumber(minutes) + 3, 7) * 7 - 3;
+    return monday * MINUTES_PER_DAY;
+}
+
+int64_t Timestamp::startOfMonth(int64_t minutes) {
+    int year, month, day;
+    civilFromDays(dayNumber(minutes), year, month, day);
+    return daysFromCivil(year, month, 1) * MINUTES_PER_DAY;
+}
+
+bool Timestamp::parseDate(const char* begin, const char* end, int64_t& days) {
+    const char* p = begin;
+    int day, month, year;
+    if (!readNumber(p, end, 2, day) || !expect(p, end, '/') ||
+        !readNumber(p, end, 2, month) || !expect(p, end, '/') ||
+        !readNumber(p, end, 4, year) || p != end) {
+        return false;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month)) {
+        return false;
+    }
+    days = daysFromCivil(year, month, day);
+    return true;
+}
+
+bool Timestamp::parseTime(const char* begin, const char* end, int& minutes) {
+    const char* p = begin;
+    int hour, minute;
+    if (!readNumber(p, end, 2, hour) || !expect(p, end, ':') ||
+        !readNumber(p, end, 2, minute) || p != end) {
+        return false;
+    }
+    if (hour > 23 || minute > 59) {
+        return false;
+    }
+    minutes = hour * 60 + minute;
+    return true;
+}
+
+bool Timestamp::parse(const std::string& date, const std::string& time, int64_t& minutes) {
+    int64_t days;
+    int inDay;
+    if (!parseDate(date.data(), date.data() + date.size(), days) ||
+        !parseTime(time.data(), time.data() + time.size(), inDay)) {
+        return false;
+    }
+    minutes = days * MINUTES_PER_DAY + inDay;
+    return true;
+}
+
+void Timestamp::formatDate(int64_t minutes, char* out) {
+    int year, month, day, hour, minute;
+    toCivil(minutes, year, month, day, hour, minute);
+    writeDigits(out, day, 2);
+    out[2] = '/';
+    writeDigits(out + 3, month, 2);
+    out[5] = '/';
+    writeDigits(out + 6, year, 4);
+}
+
+void Timestamp::formatTime(int64_t minutes, char* out) {
+    int inDay = minuteOfDay(minutes);
+    writeDigits(out, inDay / 60, 2);
+    out[2] = ':';
+    writeDigits(out + 3, inDay % 60, 2);
+}
+
+std::string Timestamp::dateString(int64_t minutes) {
+    char buffer[10];
+    formatDate(minutes, buffer);
+    return std::string(buffer, sizeof(buffer));
+}
+
+std::string Timestamp::timeString(int64_t minutes) {
+    char buffer[5];
+    formatTime(minutes, buffer);
+    return std::string(buffer, sizeof(buffer));
+}
@@ -1,22 +1,261 @@
 #include "WeatherStation.h"
+#include "CompressedArchive.h"
+#include "MappedFile.h"
+#include "MeasurementParser.h"
+#include "Snapshot.h"
+#include "TextWriter.h"
+#include "ThreadPool.h"
+#include "Timestamp.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
 #include <iostream>
 #include <fstream>
+#include <filesystem>
 #include <sstream>
+#include <unordered_set>
+
+double WeatherStation::LoadStats::megabytesPerSecond() const {
+    if (parseSeconds <= 0.0) return 0.0;
+    return (bytes / (1024.0 * 1024.0)) / parseSeconds;
+}
 
 void WeatherStation::addMeasurement(const Measurement& m) {
+    markDirty(measurements.size());
+    idIndex.emplace(m.getId(), measurements.size());
+    size_t position = timeIndex.insert(m.getTimestamp(), measurements.size());
+    if (!rangeAggregatesStale && position == rangeAggregates.size()) {
+        rangeAggregates.append(m);
+    } else {
+        rangeAggregatesStale = true;
+    }
     measurements.push_back(m);
+    columns.append(m);
+    runningStats.add(m);
+    rollups.add(m);
+    if (concurrentReads) {
+        store.append(m);
+    }
+    logChange(Journal::RecordType::Add, m);
+    checkpointIfDue();
+}
+
+void WeatherStation::addMeasurements(const std::vector<Measurement>& batch) {
+    if (batch.empty()) {
+        return;
+    }
+    auto earlier = [](const Measurement& a, const Measurement& b) { return a.getTimestamp() < b.getTimestamp(); };
+    TimeRange all = range(INT64_MIN, INT64_MAX);
+    bool appendsInOrder = (all.empty() || all[all.size() - 1].getTimestamp() <= batch.front().getTimestamp()) &&
+                          std::is_sorted(batch.begin(), batch.end(), earlier);
+    if (appendsInOrder || batch.size() * 8 < measurements.size()) {
+        for (const Measurement& m : batch) {
+            addMeasurement(m);
+        }
+        return;
+    }
+
+    size_t first = measurements.size();
+    measurements.insert(measurements.end(), batch.begin(), batch.end());
+    for (const Measurement& m : batch) {
+        columns.append(m);
+        runningStats.add(m);
+        logChange(Journal::RecordType::Add, m);
+    }
+    markDirtyFrom(first);
+    if (concurrentReads) {
+        store.append(batch);
+    }
+    rebuildIndexes();
+    checkpointIfDue();
 }
 
 bool WeatherStation::removeMeasurement(int id) {
-    for (size_t i = 0; i < measurements.size(); i++) {
-        if (measurements[i].getId() == id) {
-            measurements.erase(measurements.begin() + i);
+    // The multimap keeps duplicates in no particular order; take the lowest slot
+    auto range = idIndex.equal_range(id);
+    if (range.first == range.second) {
+        return false;
+    }
+    auto first = range.first;
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second < first->second) {
+            first = it;
+        }
+    }
+    removeAt(first);
+    checkpointIfDue();
+    return true;
+}
+
+bool WeatherStation::removeMeasurementAt(size_t slot) {
+    if (slot >= measurements.size()) {
+        return false;
+    }
+    auto range = idIndex.equal_range(measurements[slot].getId());
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == slot) {
+            removeAt(it);
+            checkpointIfDue();
             return true;
         }
     }
     return false;
 }
 
+void WeatherStation::removeAt(std::unordered_multimap<int, size_t>::iterator entry) {
+    size_t slot = entry->second;
+    int64_t timestamp = measurements[slot].getTimestamp();
+    logChange(Journal::RecordType::Delete, measurements[slot]);
+    idIndex.erase(entry);
+    runningStats.remove(measurements[slot]);
+    timeIndex.remove(timestamp, slot);
+    rangeAggregatesStale = true;
+
+    // The later rows move down one slot, so the file keeps its order
+    for (auto& indexed : idIndex) {
+        if (indexed.second > slot) {
+            indexed.second--;
+        }
+    }
+    markDirtyFrom(slot);
+    measurements.erase(measurements.begin() + slot);
+    columns.erase(slot);
+    if (concurrentReads) {
+        store.erase(slot);
+    }
+    int64_t hour = RollupCache::bucketStart(timestamp, RollupCache::Level::Hour);
+    rollups.refresh(timestamp, range(hour, RollupCache::bucketEnd(hour, RollupCache::Level::Hour)));
+}
+
+// Journal replay: the id may repeat, so the row must match field for field
+bool WeatherStation::removeExact(const Measurement& m) {
+    auto range = idIndex.equal_range(m.getId());
+    for (auto it = range.first; it != range.second; ++it) {
+        if (std::memcmp(&measurements[it->second], &m, sizeof(Measurement)) == 0) {
+            removeAt(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WeatherStation::logChange(Journal::RecordType type, const Measurement& m) {
+    if (journal) {
+        journal->append(type, m);
+    }
+}
+
+// Only called once a change is complete, so the snapshot matches its LSN
+void WeatherStation::checkpointIfDue() {
+    if (journal && journal->checkpointDue()) {
+        journal->checkpoint(columns);
+    }
+}
+
+size_t WeatherStation::removeMeasurements(const std::vector<int>& ids) {
+    if (ids.empty()) {
+        return 0;
+    }
+    std::unordered_set<int> doomed(ids.begin(), ids.end());
+    return removeIf([&doomed](const Measurement& m) { return doomed.count(m.getId()) > 0; });
+}
+
+size_t WeatherStation::removeMeasurementsAt(const std::vector<size_t>& slots) {
+    std::vector<bool> doomed(measurements.size(), false);
+    size_t count = 0;
+    for (size_t slot : slots) {
+        if (slot < doomed.size() && !doomed[slot]) {
+            doomed[slot] = true;
+            count++;
+        }
+    }
+    if (count == 1) {
+        return removeMeasurementAt(std::find(doomed.begin(), doomed.end(), true) - doomed.begin()) ? 1 : 0;
+    }
+    return removeMarked(doomed);
+}
+
+size_t WeatherStation::removeIf(const std::function<bool(const Measurement&)>& predicate) {
+    std::vector<bool> doomed(measurements.size(), false);
+    for (size_t i = 0; i < measurements.size(); i++) {
+        doomed[i] = predicate(measurements[i]);
+    }
+    return removeMarked(doomed);
+}
+
+size_t WeatherStation::removeMarked(const std::vector<bool>& doomed) {
+    size_t firstRemoved = measurements.size();
+    for (size_t i = 0; i < measurements.size(); i++) {
+        if (doomed[i]) {
+            firstRemoved = std::min(firstRemoved, i);
+            runningStats.remove(measurements[i]);
+            logChange(Journal::RecordType::Delete, measurements[i]);
+        }
+    }
+    if (firstRemoved == measurements.size()) {
+        return 0;
+    }
+
+    size_t kept = firstRemoved;
+    for (size_t i = firstRemoved + 1; i < measurements.size(); i++) {
+        if (!doomed[i]) {
+            measurements[kept++] = measurements[i];
+        }
+    }
+    size_t removed = measurements.size() - kept;
+    measurements.resize(kept);
+    // The compaction shifted every row after the first one removed
+    markDirtyFrom(firstRemoved);
+
+    columns.assign(measurements);
+    if (concurrentReads) {
+        store.assign(measurements);
+    }
+    rebuildIndexes();
+    checkpointIfDue();
+    return removed;
+}
+
+void WeatherStation::markDirty(size_t slot) {
+    size_t block = slot / CompressedArchive::BLOCK_ROWS;
+    if (block >= dirtyBlocks.size()) {
+        dirtyBlocks.resize(block + 1, false);
+    }
+    dirtyBlocks[block] = true;
+}
+
+void WeatherStation::markDirtyFrom(size_t slot) {
+    size_t block = slot / CompressedArchive::BLOCK_ROWS;
+    size_t blocks = (measurements.size() + CompressedArchive::BLOCK_ROWS - 1) / CompressedArchive::BLOCK_ROWS;
+    if (blocks > dirtyBlocks.size()) {
+        dirtyBlocks.resize(blocks, false);
+    }
+    std::fill(dirtyBlocks.begin() + std::min(block, dirtyBlocks.size()), dirtyBlocks.end(), true);
+}
+
+void WeatherStation::rebuildIndexes(bool statistics) {
+    // The indexes only read the rows and each writes its own member, so
+    // they are built side by side; rollups need the time index first
+    std::vector<std::function<void()>> tasks;
+    tasks.push_back([this] {
+        idIndex.clear();
+        idIndex.reserve(measurements.size());
+        for (size_t i = 0; i < measurements.size(); i++) {
+            idIndex.emplace(measurements[i].getId(), i);
+        }
+    });
+    tasks.push_back([this] {
+        timeIndex.rebuild(measurements);
+        rollups.rebuild(range(INT64_MIN, INT64_MAX));
+    });
+    if (statistics) {
+        tasks.push_back([this] { runningStats.rebuild(measurements); });
+    }
+    ThreadPool::shared().parallelFor(tasks.size(), [&tasks](size_t i) { tasks[i](); });
+    rangeAggregatesStale = true;
+}
+
 void WeatherStation::displayAll() const {
     if (measurements.empty()) {
         std::cout << "No measurements available." << std::endl;
@@ -27,16 +266,139 @@ void WeatherStation::displayAll() const {
     }
 }
 
-bool WeatherStation::loadFromFile(const std::string& filename) {
+bool WeatherStation::loadFromFile(const std::string& filename, LoadMode mode, bool completeLines) {
+    auto start = std::chrono::steady_clock::now();
+
+    savedArchive.clear();
+    lastLoad.rejected = 0;
+    FileFormat format = FileFormat::Text;
+    if (Snapshot::isSnapshotFile(filename)) {
+        format = FileFormat::Snapshot;
+    } else if (CompressedArchive::isArchiveFile(filename)) {
+        format = FileFormat::Archive;
+    }
+
+    if (format != FileFormat::Text) {
+        if (!loadBinary(filename, format)) {
+            return false;
+        }
+    } else {
+        bool ok = mode == LoadMode::Stream ? loadStream(filename, completeLines)
+                                           : loadMapped(filename, mode == LoadMode::Parallel, completeLines);
+        if (!ok) {
+            return false;
+        }
+    }
+    auto parsed = std::chrono::steady_clock::now();
+    if (format == FileFormat::Text) {
+        columns.assign(measurements);
+    }
+
+    fileFormat = format;
+    if (concurrentReads) {
+        store.assign(measurements);
+    }
+    rebuildIndexes(true);
+    auto end = std::chrono::steady_clock::now();
+    lastLoad.records = measurements.size();
+    lastLoad.parseSeconds = std::chrono::duration<double>(parsed - start).count();
+    lastLoad.indexSeconds = std::chrono::duration<double>(end - parsed).count();
+    lastLoad.seconds = std::chrono::duration<double>(end - start).count();
+    if (journal) {
+        // Nothing logs the load itself, so it only counts once its snapshot
+        // is on disk. Until then the log still describes the old contents,
+        // and reopening it puts them back.
+        journal->waitForCheckpoint();
+        if (!journal->checkpoint(columns) || !journal->waitForCheckpoint()) {
+            // If even that fails the journal is left closed
+            std::string basePath = journal->getBasePath();
+            openJournal(basePath);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool WeatherStation::loadMapped(const std::string& filename, bool parallel, bool completeLines) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        return false;
+    }
+
+    const char* lineEnd = file.end();
+    while (lineEnd != file.begin() && lineEnd[-1] != '\n') {
+        lineEnd--;
+    }
+    const char* end = completeLines ? lineEnd : file.end();
+
+    measurements.clear();
+    // Rough guess of ~32 bytes per line avoids most regrowth on large files
+    measurements.reserve(file.size() / 32);
+    if (parallel) {
+        MeasurementParser::parseBufferParallel(file.begin(), end, measurements, 0, &lastLoad.rejected);
+    } else {
+        MeasurementParser::parseBuffer(file.begin(), end, measurements, &lastLoad.rejected);
+    }
+
+    lastLoad.bytes = file.size();
+    lastLoad.lineEnd = static_cast<size_t>(lineEnd - file.begin());
+    return true;
+}
+
+bool WeatherStation::loadBinary(const std::string& filename, FileFormat format) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        return false;
+    }
+
+    MeasurementColumns loaded;
+    CompressedArchive::BlockIndex index;
+    bool ok = format == FileFormat::Snapshot ? Snapshot::load(file.begin(), file.end(), loaded)
+                                             : CompressedArchive::load(file.begin(), file.end(), loaded, &index);
+    if (!ok) {
+        return false;
+    }
+    columns = std::move(loaded);
+    rowsFromColumns();
+    if (format == FileFormat::Archive) {
+        savedArchive = filename;
+        savedIndex = std::move(index);
+        dirtyBlocks.clear();
+    }
+
+    lastLoad.bytes = file.size();
+    lastLoad.lineEnd = file.size();
+    return true;
+}
+
+void WeatherStation::rowsFromColumns() {
+    measurements.resize(columns.size());
+    for (size_t i = 0; i < measurements.size(); i++) {
+        measurements[i] = columns.row(i);
+    }
+}
+
+bool WeatherStation::loadStream(const std::string& filename, bool completeLines) {
     std::ifstream file(filename.c_str());
     if (!file.is_open()) {
         return false;
     }
 
     measurements.clear();
+    lastLoad.bytes = 0;
     std::string line;
+    size_t tailBytes = 0;
 
     while (std::getline(file, line)) {
+        if (file.eof()) {
+            // No '\n' after this line
+            tailBytes = line.size();
+            lastLoad.bytes += line.size();
+            if (completeLines) break;
+        } else {
+            lastLoad.bytes += line.size() + 1;
+        }
+        if (!line.empty() && line.back() == '\r') line.pop_back();
         if (line.empty()) continue;
 
         std::stringstream ss(line);
@@ -65,28 +427,153 @@ bool WeatherStation::loadFromFile(const std::string& filename) {
             time = token;
         }
 
-        Measurement m(id, temp, hum, wind, date, time);
-        measurements.push_back(m);
+        int64_t timestamp;
+        if (!Timestamp::parse(date, time, timestamp)) {
+            lastLoad.rejected++;
+            continue;
+        }
+        measurements.push_back(Measurement(id, temp, hum, wind, timestamp));
     }
 
     file.close();
+    // Counted from the end, as text mode may drop a '\r' from every line
+    std::error_code error;
+    size_t size = static_cast<size_t>(std::filesystem::file_size(filename, error));
+    lastLoad.lineEnd = (error ? lastLoad.bytes : size) - tailBytes;
     return true;
 }
 
 bool WeatherStation::saveToFile(const std::string& filename) const {
-    std::ofstream file(filename.c_str());
-    if (!file.is_open()) {
-        return false;
-    }
+    return saveToFile(filename, fileFormat);
+}
 
-    for (size_t i = 0; i < measurements.size(); i++) {
-        file << measurements[i].toTextLine() << std::endl;
+bool WeatherStation::saveToFile(const std::string& filename, FileFormat format) const {
+    if (format != FileFormat::Archive && filename == savedArchive) {
+        savedArchive.clear();
+    }
+    if (format == FileFormat::Snapshot) {
+        return Snapshot::save(filename, columns);
+    }
+    if (format == FileFormat::Archive) {
+        if (filename == savedArchive && CompressedArchive::update(filename, columns, dirtyBlocks, savedIndex)) {
+            dirtyBlocks.clear();
+            return true;
+        }
+        // A failed save leaves the old file, so the old index stays valid
+        if (!CompressedArchive::save(filename, columns, &savedIndex)) {
+            return false;
+        }
+        savedArchive = filename;
+        dirtyBlocks.clear();
+        return true;
     }
 
-    file.close();
-    return true;
+    return TextWriter::write(filename, measurements);
+}
+
+WeatherStation::FileFormat WeatherStation::getFileFormat() const {
+    return fileFormat;
 }
 
 const std::vector<Measurement>& WeatherStation::getMeasurements() const {
     return measurements;
 }
+
+const MeasurementColumns& WeatherStation::getColumns() const {
+    return columns;
+}
+
+Analyzer::Summary WeatherStation::getStatistics() const {
+    return runningStats.summary();
+}
+
+Analyzer::Summary WeatherStation::getStatistics(int64_t from, int64_t to) const {
+    return rollups.query(from, to, timeIndex, measurements);
+}
+
+const RollupCache& WeatherStation::getRollups() const {
+    return rollups;
+}
+
+TimeRange WeatherStation::range(int64_t from, int64_t to) const {
+    return timeIndex.range(from, to, measurements);
+}
+
+RangeAggregateIndex::Aggregate WeatherStation::aggregatePositions(RangeAggregateIndex::Field field,
+                                                                  size_t first, size_t last) const {
+    // Readers may query from several threads at once; the first one after a
+    // change rebuilds, the rest wait for it
+    std::lock_guard<std::mutex> lock(rangeAggregatesMutex);
+    if (rangeAggregatesStale) {
+        rangeAggregates.build(timeIndex.range(INT64_MIN, INT64_MAX, measurements));
+        rangeAggregatesStale = false;
+    }
+    return rangeAggregates.query(field, first, last);
+}
+
+RangeAggregateIndex::Aggregate WeatherStation::aggregateWindow(RangeAggregateIndex::Field field,
+                                                               int64_t from, int64_t to) const {
+    std::pair<size_t, size_t> window = timeIndex.bounds(from, to);
+    return aggregatePositions(field, window.first, window.second);
+}
+
+const WeatherStation::LoadStats& WeatherStation::getLastLoadStats() const {
+    return lastLoad;
+}
+
+bool WeatherStation::openJournal(const std::string& basePath) {
+    closeJournal();
+
+    auto opened = std::make_unique<Journal>();
+    MeasurementColumns snapshot;
+    std::vector<Journal::Record> tail;
+    if (!opened->open(basePath, snapshot, tail)) {
+        return false;
+    }
+
+    columns = std::move(snapshot);
+    rowsFromColumns();
+    savedArchive.clear();
+    if (concurrentReads) {
+        store.assign(measurements);
+    }
+    rebuildIndexes(true);
+    // journal is still null here, so the replay is not logged a second time
+    for (const Journal::Record& record : tail) {
+        if (record.type == Journal::RecordType::Add) {
+            addMeasurement(record.measurement);
+        } else {
+            removeExact(record.measurement);
+        }
+    }
+    journal = std::move(opened);
+    return true;
+}
+
+void WeatherStation::closeJournal() {
+    if (journal) {
+        journal->close();
+        journal.reset();
+    }
+}
+
+bool WeatherStation::syncJournal() {
+    return journal ? journal->sync() : false;
+}
+
+bool WeatherStation::checkpoint() {
+    if (!journal) return false;
+    journal->waitForCheckpoint();
+    return journal->checkpoint(columns);
+}
+
+void WeatherStation::enableConcurrentReads() {
+    if (!concurrentReads) {
+        concurrentReads = true;
+        store.assign(measurements);
+    }
+}
+
+ConcurrentStore::Snapshot WeatherStation::snapshot() const {
+    return store.snapshot();
+}
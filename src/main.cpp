@@ -1,7 +1,10 @@
+#include <cstring>
 #include <iostream>
 #include "Measurement.h"
+#include "Timestamp.h"
 #include "WeatherStation.h"
 #include "Analyzer.h"
+#include "TailFollower.h"
 
 using namespace std;
 
@@ -18,12 +21,72 @@ void displayMenu() {
     cout << "Choice: ";
 }
 
-int main() {
+// weather_station_console --convert <input> <output> [snapshot|archive|text]
+// The input may be in any format; the output defaults to a snapshot.
+int convertFile(const char* input, const char* output, const char* formatName) {
+    WeatherStation::FileFormat format = WeatherStation::FileFormat::Snapshot;
+    if (strcmp(formatName, "archive") == 0) {
+        format = WeatherStation::FileFormat::Archive;
+    } else if (strcmp(formatName, "text") == 0) {
+        format = WeatherStation::FileFormat::Text;
+    } else if (strcmp(formatName, "snapshot") != 0) {
+        cerr << "Unknown format " << formatName << endl;
+        return 1;
+    }
+
+    WeatherStation station;
+    if (!station.loadFromFile(input) || !station.saveToFile(output, format)) {
+        cerr << "Cannot convert " << input << " to " << output << endl;
+        return 1;
+    }
+    cout << "Wrote " << station.getMeasurements().size() << " measurements to " << output << endl;
+    return 0;
+}
+
+// weather_station_console --follow <file>
+// Reads the file, then keeps adding the lines appended to it until killed.
+int followFile(const char* filename) {
+    WeatherStation station;
+    TailFollower follower;
+    if (!follower.open(filename)) {
+        cerr << "Cannot open " << filename << endl;
+        return 1;
+    }
+    while (true) {
+        size_t added = follower.poll(station);
+        if (added > 0) {
+            cout << "+" << added << " measurements, " << station.getMeasurements().size() << " total" << endl;
+        }
+        follower.wait(1000);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if ((argc == 4 || argc == 5) && strcmp(argv[1], "--convert") == 0) {
+        return convertFile(argv[2], argv[3], argc == 5 ? argv[4] : "snapshot");
+    }
+    if (argc == 3 && strcmp(argv[1], "--follow") == 0) {
+        return followFile(argv[2]);
+    }
+
     WeatherStation station;
     string dataFile = "data/measurements.txt";
     int choice = 0;
     int nextId = 1;
 
+    // --journal <base path>: every change is logged as it happens (see Journal)
+    bool journaled = argc == 3 && strcmp(argv[1], "--journal") == 0;
+    if (journaled) {
+        if (!station.openJournal(argv[2])) {
+            cerr << "Cannot open journal " << argv[2] << endl;
+            return 1;
+        }
+        for (const Measurement& m : station.getMeasurements()) {
+            if (m.getId() >= nextId) nextId = m.getId() + 1;
+        }
+        cout << "Journal " << argv[2] << ": " << station.getMeasurements().size() << " measurements" << endl;
+    }
+
     while (choice != 7) {
         displayMenu();
         cin >> choice;
@@ -39,12 +102,25 @@ int main() {
                 cin >> hum;
                 cout << "Wind Speed (km/h): ";
                 cin >> wind;
-                cout << "Date (DD/MM/YYYY): ";
-                cin >> date;
-                cout << "Time (HH:MM): ";
-                cin >> time;
+                int64_t days;
+                int minutes;
+                while (true) {
+                    cout << "Date (DD/MM/YYYY): ";
+                    cin >> date;
+                    if (!cin || Timestamp::parseDate(date.data(), date.data() + date.size(), days)) break;
+                    cout << "Invalid date." << endl;
+                }
+                while (true) {
+                    cout << "Time (HH:MM): ";
+                    cin >> time;
+                    if (!cin || Timestamp::parseTime(time.data(), time.data() + time.size(), minutes)) break;
+                    cout << "Invalid time." << endl;
+                }
+                if (!cin) {
+                    return 1;
+                }
 
-                Measurement m(nextId, temp, hum, wind, date, time);
+                Measurement m(nextId, temp, hum, wind, days * Timestamp::MINUTES_PER_DAY + minutes);
                 station.addMeasurement(m);
                 nextId++;
 
@@ -70,14 +146,23 @@ int main() {
             }
             case 4: {
                 if (station.loadFromFile(dataFile)) {
+                    const WeatherStation::LoadStats& stats = station.getLastLoadStats();
                     cout << "Data loaded from file." << endl;
+                    cout << stats.records << " records, " << stats.bytes << " bytes parsed in "
+                         << stats.parseSeconds * 1000.0 << " ms (" << stats.megabytesPerSecond() << " MB/s), "
+                         << "indexed in " << stats.indexSeconds * 1000.0 << " ms" << endl;
+                    if (stats.rejected > 0) {
+                        cout << stats.rejected << " lines skipped for a bad date or time." << endl;
+                    }
                 } else {
                     cout << "Error loading file." << endl;
                 }
                 break;
             }
             case 5: {
-                if (station.saveToFile(dataFile)) {
+                if (journaled) {
+                    cout << (station.syncJournal() ? "Journal is up to date." : "Error writing journal.") << endl;
+                } else if (station.saveToFile(dataFile)) {
                     cout << "Data saved to file." << endl;
                 } else {
                     cout << "Error saving file." << endl;
@@ -85,7 +170,8 @@ int main() {
                 break;
             }
             case 6: {
-                Analyzer::displayStats(station.getMeasurements());
+                Analyzer::displayStats(station.getStatistics());
+                Analyzer::displayPercentiles(station.getColumns());
                 break;
             }
             case 7: {
@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CompressedArchive.h"
+#include "FieldScanner.h"
+#include "MappedFile.h"
+#include "MeasurementColumns.h"
+#include "Reductions.h"
+#include "Timestamp.h"
+#include "WeatherStation.h"
+
+using namespace std;
+
+// Micro-benchmarks.
+// Usage: weather_station_bench [file]
+//        weather_station_bench reduce [samples...]
+//        weather_station_bench archive [rows...]
+// Without a file, a synthetic one with 2 million lines is generated.
+// The reduce mode defaults to 1M, 100M and 1B samples (1B needs 4 GB of RAM).
+// The archive mode defaults to 3M rows of a per-minute random walk.
+
+namespace {
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+string generateFile(size_t lines) {
+    string filename = "bench_measurements.txt";
+    ofstream file(filename.c_str());
+    mt19937 rng(42);
+    uniform_real_distribution<float> temp(-20.0f, 40.0f);
+    uniform_real_distribution<float> percent(0.0f, 100.0f);
+    uniform_int_distribution<int> day(1, 28), month(1, 12), hour(0, 23), minute(0, 59);
+
+    char line[96];
+    for (size_t i = 0; i < lines; i++) {
+        int n = snprintf(line, sizeof(line), "%zu;%.1f;%.1f;%.1f;%02d/%02d/2024;%02d:%02d\n",
+                         i + 1, temp(rng), percent(rng), percent(rng) / 2, day(rng), month(rng),
+                         hour(rng), minute(rng));
+        file.write(line, n);
+    }
+    return filename;
+}
+
+void benchLoad(const string& filename, WeatherStation::LoadMode mode, const char* name) {
+    WeatherStation station;
+    station.loadFromFile(filename, mode);
+    const WeatherStation::LoadStats& stats = station.getLastLoadStats();
+    printf("%-22s %10zu records  parse %9.1f ms %9.1f MB/s  index %9.1f ms\n", name, stats.records,
+           stats.parseSeconds * 1000.0, stats.megabytesPerSecond(), stats.indexSeconds * 1000.0);
+}
+
+void benchScan(const MappedFile& file, FieldScanner::Kernel kernel) {
+    vector<uint32_t> index;
+    const size_t block = 256 * 1024;
+    size_t delimiters = 0;
+
+    auto start = chrono::steady_clock::now();
+    for (const char* p = file.begin(); p < file.end(); p += block) {
+        const char* end = file.end() - p > static_cast<ptrdiff_t>(block) ? p + block : file.end();
+        FieldScanner::buildIndex(p, end, index, kernel);
+        delimiters += index.size();
+    }
+    double seconds = secondsSince(start);
+
+    printf("scan %-17s %10zu delims  %9.1f ms %9.1f MB/s\n", FieldScanner::kernelName(kernel), delimiters,
+           seconds * 1000.0, file.size() / (1024.0 * 1024.0) / seconds);
+}
+
+bool sameBits(const Reductions::Result& a, const Reductions::Result& b) {
+    return memcmp(&a.sum, &b.sum, sizeof(double)) == 0 &&
+           memcmp(&a.m2, &b.m2, sizeof(double)) == 0 &&
+           memcmp(&a.min, &b.min, sizeof(float)) == 0 &&
+           memcmp(&a.max, &b.max, sizeof(float)) == 0;
+}
+
+void benchReduce(size_t samples) {
+    vector<float> values(samples);
+    mt19937 rng(7);
+    normal_distribution<float> temp(12.0f, 9.0f);
+    for (float& v : values) v = temp(rng);
+
+    // Extended-precision reference for the accuracy column
+    long double exact = 0.0L;
+    for (float v : values) exact += v;
+
+    printf("%zu samples\n", samples);
+
+    // The float accumulator Analyzer used before, for scale
+    auto start = chrono::steady_clock::now();
+    float floatSum = 0.0f;
+    for (float v : values) floatSum += v;
+    double floatSeconds = secondsSince(start);
+    printf("  %-21s %9.1f ms %8.1f GB/s         rel.err %.2e\n", "float loop", floatSeconds * 1000.0,
+           samples * sizeof(float) / 1e9 / floatSeconds, static_cast<double>(fabsl((floatSum - exact) / exact)));
+
+    const Reductions::Summation modes[] = {Reductions::Summation::Fast, Reductions::Summation::Compensated};
+    const Reductions::Kernel kernels[] = {Reductions::Kernel::Portable, Reductions::Kernel::AVX2,
+                                          Reductions::Kernel::AVX512};
+    for (Reductions::Summation mode : modes) {
+        Reductions::Result reference;
+        double referenceSeconds = 0.0;
+        for (Reductions::Kernel kernel : kernels) {
+            if (kernel > Reductions::bestKernel()) break;
+
+            auto start = chrono::steady_clock::now();
+            Reductions::Result result = Reductions::reduce(values, kernel, mode);
+            double seconds = secondsSince(start);
+
+            if (kernel == Reductions::Kernel::Portable) {
+                reference = result;
+                referenceSeconds = seconds;
+            }
+            double relativeError = static_cast<double>(fabsl((result.sum - exact) / exact));
+            printf("  %-11s %-9s %9.1f ms %8.1f GB/s  x%-5.1f rel.err %.2e  %s\n",
+                   mode == Reductions::Summation::Fast ? "fast" : "compensated", Reductions::kernelName(kernel),
+                   seconds * 1000.0, samples * sizeof(float) / 1e9 / seconds, referenceSeconds / seconds,
+                   relativeError, sameBits(result, reference) ? "identical" : "DIFFERENT");
+        }
+    }
+}
+
+// Per-minute readings at sensor resolution (0.1), drifting slowly, which is
+// what CompressedArchive is built for
+MeasurementColumns sensorSeries(size_t rows) {
+    MeasurementColumns columns;
+    columns.reserve(rows);
+    mt19937 rng(3);
+    uniform_int_distribution<int> step(-1, 1);
+    int temp = 150, hum = 600, wind = 80;
+    int64_t start = Timestamp::fromCivil(2024, 1, 1);
+    for (size_t i = 0; i < rows; i++) {
+        if (i % 5 == 0) temp += step(rng);
+        if (i % 7 == 0) hum = min(1000, max(0, hum + step(rng)));
+        if (i % 3 == 0) wind = max(0, wind + step(rng));
+        columns.append(Measurement(static_cast<int>(i + 1), temp / 10.0f, hum / 10.0f, wind / 10.0f,
+                                   start + static_cast<int64_t>(i)));
+    }
+    return columns;
+}
+
+template <typename T>
+bool sameColumn(span<const T> a, span<const T> b) {
+    return a.size() == b.size() && memcmp(a.data(), b.data(), a.size_bytes()) == 0;
+}
+
+void benchArchive(size_t rows) {
+    MeasurementColumns columns = sensorSeries(rows);
+    size_t textBytes = 0;
+    char line[Measurement::MAX_TEXT_LINE + 1];
+    for (size_t i = 0; i < rows; i++) {
+        textBytes += columns.row(i).formatTextLine(line) - line + 1;
+    }
+    // What the decoder produces: the five columns
+    size_t columnBytes = rows * (sizeof(int64_t) + sizeof(int) + 3 * sizeof(float));
+
+    string filename = "bench_archive.wsarc";
+    auto start = chrono::steady_clock::now();
+    bool saved = CompressedArchive::save(filename, columns);
+    double encodeSeconds = secondsSince(start);
+
+    MappedFile file;
+    if (!saved || !file.open(filename)) {
+        printf("%zu rows: cannot write %s\n", rows, filename.c_str());
+        return;
+    }
+    MeasurementColumns decoded;
+    start = chrono::steady_clock::now();
+    bool loaded = CompressedArchive::load(file.begin(), file.end(), decoded);
+    double decodeSeconds = secondsSince(start);
+    bool same = loaded && sameColumn(decoded.getTimestamps(), columns.getTimestamps()) &&
+                sameColumn(decoded.getIds(), columns.getIds()) &&
+                sameColumn(decoded.getTemperatures(), columns.getTemperatures()) &&
+                sameColumn(decoded.getHumidities(), columns.getHumidities()) &&
+                sameColumn(decoded.getWindSpeeds(), columns.getWindSpeeds());
+
+    printf("%zu rows\n", rows);
+    printf("  text %9.1f MB  archive %7.1f MB  ratio %5.1fx  %5.1f bits/row\n", textBytes / 1e6,
+           file.size() / 1e6, static_cast<double>(textBytes) / file.size(), file.size() * 8.0 / rows);
+    printf("  encode %9.1f ms %8.1f MB/s of columns\n", encodeSeconds * 1000.0, columnBytes / 1e6 / encodeSeconds);
+    printf("  decode %9.1f ms %8.1f MB/s of columns  %s\n", decodeSeconds * 1000.0,
+           columnBytes / 1e6 / decodeSeconds, same ? "identical" : "DIFFERENT");
+    file.close();
+    remove(filename.c_str());
+}
+
+int runArchive(int argc, char* argv[]) {
+    printf("%u threads\n\n", thread::hardware_concurrency());
+    if (argc > 2) {
+        for (int i = 2; i < argc; i++) benchArchive(strtoull(argv[i], nullptr, 10));
+    } else {
+        benchArchive(3000000);
+    }
+    return 0;
+}
+
+int runReduce(int argc, char* argv[]) {
+    printf("best reduction kernel %s\n\n", Reductions::kernelName(Reductions::bestKernel()));
+    if (argc > 2) {
+        for (int i = 2; i < argc; i++) benchReduce(strtoull(argv[i], nullptr, 10));
+    } else {
+        benchReduce(1000000);
+        benchReduce(100000000);
+        benchReduce(1000000000);
+    }
+    return 0;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "reduce") == 0) {
+        return runReduce(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "archive") == 0) {
+        return runArchive(argc, argv);
+    }
+
+    string filename = argc > 1 ? argv[1] : generateFile(2000000);
+
+    MappedFile file;
+    if (!file.open(filename)) {
+        cerr << "Cannot open " << filename << endl;
+        return 1;
+    }
+    printf("%s: %.1f MB, best kernel %s\n\n", filename.c_str(), file.size() / (1024.0 * 1024.0),
+           FieldScanner::kernelName(FieldScanner::bestKernel()));
+
+    benchScan(file, FieldScanner::Kernel::Scalar);
+    if (FieldScanner::bestKernel() != FieldScanner::Kernel::Scalar) {
+        benchScan(file, FieldScanner::Kernel::SSE2);
+    }
+    if (FieldScanner::bestKernel() == FieldScanner::Kernel::AVX2) {
+        benchScan(file, FieldScanner::Kernel::AVX2);
+    }
+    printf("\n");
+
+    benchLoad(filename, WeatherStation::LoadMode::Stream, "load getline");
+    benchLoad(filename, WeatherStation::LoadMode::Mapped, "load mapped+index");
+    benchLoad(filename, WeatherStation::LoadMode::Parallel, "load parallel");
+
+    return 0;
+}
@@ -0,0 +1,342 @@
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+#include "CompressedArchive.h"
+#include "Crc32.h"
+#include "MeasurementColumns.h"
+#include "Timestamp.h"
+#include "WeatherStation.h"
+
+// CompressedArchive, run by ctest. Exits non-zero on failure. Covers the
+// block codec bit for bit on awkward values, whole files, corruption,
+// update(), reading a version 1 file, and WeatherStation's incremental
+// archive saves.
+
+namespace {
+
+namespace fs = std::filesystem;
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (!ok) {
+        failures++;
+        printf("FAIL %s\n", what);
+    }
+}
+
+template <typename T>
+bool sameBits(std::span<const T> a, std::span<const T> b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size_bytes()) == 0;
+}
+
+bool sameColumns(const MeasurementColumns& a, const MeasurementColumns& b) {
+    return sameBits(a.getIds(), b.getIds()) && sameBits(a.getTemperatures(), b.getTemperatures()) &&
+           sameBits(a.getHumidities(), b.getHumidities()) && sameBits(a.getWindSpeeds(), b.getWindSpeeds()) &&
+           sameBits(a.getTimestamps(), b.getTimestamps());
+}
+
+std::string readFile(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+bool loadFile(const fs::path& path, MeasurementColumns& columns, CompressedArchive::BlockIndex* index = nullptr) {
+    std::string bytes = readFile(path);
+    return CompressedArchive::load(bytes.data(), bytes.data() + bytes.size(), columns, index);
+}
+
+// Every float the Gorilla XOR has to carry through unchanged
+const float SPECIAL[] = {
+    0.0f, -0.0f, std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+    std::numeric_limits<float>::quiet_NaN(), std::bit_cast<float>(0x7fc12345u), std::bit_cast<float>(0xffa00001u),
+    std::numeric_limits<float>::denorm_min(), std::numeric_limits<float>::min(), std::numeric_limits<float>::max(),
+    -std::numeric_limits<float>::max(), 1.0f, 1.0f, 1.0f,
+};
+
+const int IDS[] = {INT_MIN, INT_MAX, 0, -1, 7, 7, 7, INT_MAX, INT_MIN, 3};
+
+const int64_t TIMESTAMPS[] = {0, 1, 2, 3, 3, 3, -5, INT64_MAX / 4, INT64_MIN / 4, 100, 101, 1000000};
+
+// Mostly a steady per-minute series, with every special value, id and
+// timestamp step mixed in along the way
+MeasurementColumns awkward(size_t rows) {
+    MeasurementColumns columns;
+    int64_t start = Timestamp::fromCivil(2024, 1, 1);
+    const size_t specials = std::size(SPECIAL), ids = std::size(IDS), jumps = std::size(TIMESTAMPS);
+    for (size_t i = 0; i < rows; i++) {
+        float temperature = i % 5 == 0 ? SPECIAL[i / 5 % specials] : 10.0f + (i % 50) * 0.1f;
+        float humidity = i % 3 == 0 ? SPECIAL[(i / 3 + 4) % specials] : 55.5f;
+        float windSpeed = SPECIAL[i % specials];
+        int id = i % 4 == 0 ? IDS[i / 4 % ids] : static_cast<int>(i / 2);
+        int64_t timestamp = i % 9 == 0 ? TIMESTAMPS[i / 9 % jumps] : start + static_cast<int64_t>(i);
+        columns.append(Measurement(id, temperature, humidity, windSpeed, timestamp));
+    }
+    return columns;
+}
+
+MeasurementColumns slice(const MeasurementColumns& columns, size_t first, size_t count) {
+    MeasurementColumns out;
+    for (size_t i = first; i < first + count; i++) {
+        out.append(columns.row(i));
+    }
+    return out;
+}
+
+void checkBlocks() {
+    MeasurementColumns columns = awkward(CompressedArchive::BLOCK_ROWS);
+    const size_t sizes[] = {1, 2, 3, 63, 64, 65, 1000, CompressedArchive::BLOCK_ROWS};
+    for (size_t rows : sizes) {
+        MeasurementColumns in = slice(columns, 0, rows);
+        std::vector<uint8_t> payload;
+        CompressedArchive::encodeBlock(in.getTimestamps(), in.getIds(), in.getTemperatures(), in.getHumidities(),
+                                       in.getWindSpeeds(), payload);
+        std::vector<int64_t> timestamps(rows);
+        std::vector<int> ids(rows);
+        std::vector<float> temperatures(rows), humidities(rows), windSpeeds(rows);
+        bool ok = CompressedArchive::decodeBlock(payload.data(), payload.data() + payload.size(), rows,
+                                                 timestamps.data(), ids.data(), temperatures.data(),
+                                                 humidities.data(), windSpeeds.data());
+        MeasurementColumns out;
+        out.assign(std::move(ids), std::move(temperatures), std::move(humidities), std::move(windSpeeds),
+                   std::move(timestamps));
+        check(ok && sameColumns(in, out), "a block decodes bit for bit");
+
+        std::vector<int64_t> t(rows);
+        std::vector<int> d(rows);
+        std::vector<float> f(rows * 3);
+        check(!CompressedArchive::decodeBlock(payload.data(), payload.data() + payload.size() / 2, rows, t.data(),
+                                              d.data(), f.data(), f.data() + rows, f.data() + 2 * rows),
+              "a cut payload is rejected");
+    }
+}
+
+void checkFiles(const fs::path& directory) {
+    fs::path path = directory / "round.wsarc";
+    MeasurementColumns columns = awkward(3 * CompressedArchive::BLOCK_ROWS + 17);
+    CompressedArchive::BlockIndex index;
+    check(CompressedArchive::save(path.string(), columns, &index), "save");
+    check(CompressedArchive::isArchiveFile(path.string()), "isArchiveFile");
+    check(index.blocks.size() == 4 && index.fileBytes == fs::file_size(path), "index of a saved file");
+
+    MeasurementColumns loaded;
+    CompressedArchive::BlockIndex loadedIndex;
+    check(loadFile(path, loaded, &loadedIndex), "load");
+    check(sameColumns(columns, loaded), "every field comes back bit for bit");
+    check(loadedIndex.indexOffset == index.indexOffset && loadedIndex.blocks.size() == index.blocks.size(),
+          "load reads the index back");
+
+    MeasurementColumns empty;
+    check(CompressedArchive::save(path.string(), empty) && loadFile(path, loaded) && loaded.empty(),
+          "empty columns round trip");
+
+    // Corruption anywhere is caught by a CRC or a bounds check
+    CompressedArchive::save(path.string(), columns);
+    std::string good = readFile(path);
+    MeasurementColumns kept = awkward(10);
+    MeasurementColumns before = kept;
+    // Row count, index offset, a frame, a payload and the index
+    const size_t positions[] = {16, 24, 32, 60, good.size() / 2, good.size() - 5};
+    for (size_t at : positions) {
+        std::string bad = good;
+        bad[at] ^= 0x04;
+        check(!CompressedArchive::load(bad.data(), bad.data() + bad.size(), kept), "a flipped bit is rejected");
+    }
+    check(!CompressedArchive::load(good.data(), good.data() + good.size() - 1, kept), "a cut file is rejected");
+    check(sameColumns(kept, before), "a rejected load leaves the columns alone");
+}
+
+void checkUpdate(const fs::path& directory) {
+    fs::path path = directory / "update.wsarc";
+    const size_t blockRows = CompressedArchive::BLOCK_ROWS;
+    MeasurementColumns columns = awkward(4 * blockRows);
+    CompressedArchive::BlockIndex index;
+    CompressedArchive::save(path.string(), columns, &index);
+    uint64_t firstBlock = index.blocks[0].offset;
+
+    // Change a row in block 2 only
+    MeasurementColumns changed;
+    for (size_t i = 0; i < columns.size(); i++) {
+        Measurement m = columns.row(i);
+        if (i == 2 * blockRows + 5) m.setTemperature(-99.5f);
+        changed.append(m);
+    }
+    std::vector<bool> dirty(4, false);
+    dirty[2] = true;
+    check(CompressedArchive::update(path.string(), changed, dirty, index), "update");
+    MeasurementColumns loaded;
+    check(loadFile(path, loaded) && sameColumns(changed, loaded), "update writes the changed block");
+    check(index.blocks[0].offset == firstBlock && index.blocks[2].offset > index.blocks[3].offset,
+          "only the dirty block moves");
+    check(index.fileBytes == fs::file_size(path), "update keeps the index in step with the file");
+
+    // Appended rows: the last block grows and a new one starts
+    for (size_t i = 0; i < blockRows + 3; i++) {
+        changed.append(Measurement(static_cast<int>(i), 1.5f, 2.5f, 3.5f, static_cast<int64_t>(i)));
+    }
+    check(CompressedArchive::update(path.string(), changed, {}, index) && loadFile(path, loaded) &&
+          sameColumns(changed, loaded), "update after appends");
+
+    // Rows removed from the front shift every block, so everything is
+    // rewritten and the file is compacted
+    MeasurementColumns shorter = slice(changed, 100, changed.size() - 100);
+    std::vector<bool> all(index.blocks.size(), true);
+    check(CompressedArchive::update(path.string(), shorter, all, index) && loadFile(path, loaded) &&
+          sameColumns(shorter, loaded), "update after a delete at the front");
+    fs::path fresh = directory / "fresh.wsarc";
+    CompressedArchive::save(fresh.string(), shorter);
+    check(fs::file_size(path) == fs::file_size(fresh) && index.fileBytes == fs::file_size(path),
+          "a mostly dead file is compacted");
+
+    // A file changed behind the index's back is refused
+    CompressedArchive::BlockIndex stale = index;
+    CompressedArchive::save(path.string(), awkward(10));
+    check(!CompressedArchive::update(path.string(), shorter, all, stale), "update refuses a file it did not write");
+}
+
+// Version 1: the header without indexOffset, then the frames back to back
+void writeVersion1(const fs::path& path, const MeasurementColumns& columns) {
+    struct Frame {
+        uint32_t rows;
+        uint32_t bytes;
+        uint32_t crc;
+        uint32_t reserved;
+    };
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    const char magic[8] = {'\x89', 'W', 'S', 'A', 'R', 'C', '\r', '\n'};
+    uint32_t version = 1, blockRows = CompressedArchive::BLOCK_ROWS;
+    uint64_t rowCount = columns.size();
+    file.write(magic, sizeof(magic));
+    file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    file.write(reinterpret_cast<const char*>(&blockRows), sizeof(blockRows));
+    file.write(reinterpret_cast<const char*>(&rowCount), sizeof(rowCount));
+    for (size_t first = 0; first < columns.size(); first += blockRows) {
+        size_t count = std::min<size_t>(blockRows, columns.size() - first);
+        std::vector<uint8_t> payload;
+        CompressedArchive::encodeBlock(columns.getTimestamps().subspan(first, count),
+                                       columns.getIds().subspan(first, count),
+                                       columns.getTemperatures().subspan(first, count),
+                                       columns.getHumidities().subspan(first, count),
+                                       columns.getWindSpeeds().subspan(first, count), payload);
+        Frame frame = {static_cast<uint32_t>(count), static_cast<uint32_t>(payload.size()),
+                       Crc32::compute(payload.data(), payload.size()), 0};
+        file.write(reinterpret_cast<const char*>(&frame), sizeof(frame));
+        file.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+    }
+}
+
+void checkVersion1(const fs::path& directory) {
+    fs::path path = directory / "old.wsarc";
+    MeasurementColumns columns = awkward(2 * CompressedArchive::BLOCK_ROWS + 1);
+    writeVersion1(path, columns);
+
+    MeasurementColumns loaded;
+    CompressedArchive::BlockIndex index;
+    check(loadFile(path, loaded, &index) && sameColumns(columns, loaded), "a version 1 file loads");
+    check(index.indexOffset == 0 && index.blocks.size() == 3, "a version 1 file has no index");
+
+    // update() cannot append to it; a full save rewrites it as version 2
+    std::vector<bool> dirty(3, true);
+    check(!CompressedArchive::update(path.string(), loaded, dirty, index), "update refuses version 1");
+    check(CompressedArchive::save(path.string(), loaded, &index) && index.indexOffset != 0, "save upgrades");
+    uint32_t version = 0;
+    std::string bytes = readFile(path);
+    std::memcpy(&version, bytes.data() + 8, sizeof(version));
+    check(version == CompressedArchive::VERSION, "the saved file is the current version");
+    check(loadFile(path, loaded) && sameColumns(columns, loaded), "the upgraded file round trips");
+}
+
+bool sameRows(const WeatherStation& station, const fs::path& path) {
+    WeatherStation loaded;
+    if (!loaded.loadFromFile(path.string())) return false;
+    const std::vector<Measurement>& a = loaded.getMeasurements();
+    const std::vector<Measurement>& b = station.getMeasurements();
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(Measurement)) == 0;
+}
+
+CompressedArchive::BlockIndex indexOf(const fs::path& path) {
+    MeasurementColumns columns;
+    CompressedArchive::BlockIndex index;
+    loadFile(path, columns, &index);
+    return index;
+}
+
+void checkStationSaves(const fs::path& directory) {
+    fs::path path = directory / "station.wsarc";
+    const size_t blockRows = CompressedArchive::BLOCK_ROWS;
+    MeasurementColumns columns = awkward(5 * blockRows);
+    CompressedArchive::save(path.string(), columns);
+
+    WeatherStation station;
+    check(station.loadFromFile(path.string()), "station loads an archive");
+    check(station.getFileFormat() == WeatherStation::FileFormat::Archive, "archive format detected");
+    CompressedArchive::BlockIndex before = indexOf(path);
+
+    // Appends only touch the last block and the new one
+    station.addMeasurement(Measurement(1, 1.0f, 2.0f, 3.0f, Timestamp::fromCivil(2030, 1, 1)));
+    check(station.saveToFile(path.string()) && sameRows(station, path), "save after an append");
+    CompressedArchive::BlockIndex after = indexOf(path);
+    bool kept = after.blocks.size() == 6;
+    for (size_t b = 0; kept && b < 5; b++) {
+        kept = after.blocks[b].offset == before.blocks[b].offset;
+    }
+    check(kept, "an append leaves the full blocks where they were");
+
+    // A delete in block 3 moves the rows after it, and the appended row
+    // back into block 4: blocks 0-2 stay
+    station.removeMeasurementAt(3 * blockRows + 10);
+    check(station.saveToFile(path.string()) && sameRows(station, path), "save after a delete");
+    CompressedArchive::BlockIndex deleted = indexOf(path);
+    check(deleted.blocks.size() == 5 && deleted.blocks[2].offset == before.blocks[2].offset,
+          "a delete leaves the blocks before it where they were");
+
+    // Nothing changed: the file stays as it is
+    uintmax_t size = fs::file_size(path);
+    check(station.saveToFile(path.string()) && fs::file_size(path) == size, "a save with no changes");
+
+    // A file replaced behind the station's back is saved in full
+    CompressedArchive::save(path.string(), awkward(3));
+    station.removeMeasurementAt(0);
+    check(station.saveToFile(path.string()) && sameRows(station, path), "save over a file changed elsewhere");
+
+    // Another name, or another format in between, is always a full save
+    fs::path other = directory / "other.wsarc";
+    check(station.saveToFile(other.string()) && sameRows(station, other), "save under another name");
+    check(station.saveToFile(path.string(), WeatherStation::FileFormat::Snapshot), "snapshot over the archive");
+    station.removeMeasurementAt(1);
+    check(station.saveToFile(path.string(), WeatherStation::FileFormat::Archive) && sameRows(station, path),
+          "archive after a snapshot under the same name");
+}
+
+}
+
+int main() {
+    fs::path directory = fs::temp_directory_path() / "weather_station_archive_test";
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+
+    checkBlocks();
+    checkFiles(directory);
+    checkUpdate(directory);
+    checkVersion1(directory);
+    checkStationSaves(directory);
+
+    fs::remove_all(directory);
+    if (failures > 0) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All CompressedArchive checks passed\n");
+    return 0;
+}
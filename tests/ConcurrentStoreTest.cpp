@@ -0,0 +1,180 @@
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+#include "Analyzer.h"
+#include "ConcurrentStore.h"
+#include "WeatherStation.h"
+
+// ConcurrentStore snapshots, run by ctest. Exits non-zero on failure.
+// A snapshot must keep exactly the rows it was taken with through later
+// appends, erases and assigns, and readers on other threads must only
+// ever see whole, published rows.
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (!ok) {
+        failures++;
+        printf("FAIL %s\n", what);
+    }
+}
+
+Measurement row(int i) {
+    return Measurement(i, i * 0.25f, static_cast<float>(i % 100), i % 7 * 1.5f, 1000 + i);
+}
+
+bool sameRow(const Measurement& a, const Measurement& b) {
+    return std::memcmp(&a, &b, sizeof(Measurement)) == 0;
+}
+
+bool holds(const ConcurrentStore::Snapshot& snapshot, const std::vector<Measurement>& rows) {
+    if (snapshot.size() != rows.size()) return false;
+    for (size_t i = 0; i < rows.size(); i++) {
+        if (!sameRow(snapshot.row(i), rows[i])) return false;
+    }
+    return true;
+}
+
+bool sameSummary(const Analyzer::Summary& a, const Analyzer::Summary& b) {
+    return std::memcmp(&a.temperature, &b.temperature, sizeof(a.temperature)) == 0 &&
+           std::memcmp(&a.humidity, &b.humidity, sizeof(a.humidity)) == 0 &&
+           std::memcmp(&a.windSpeed, &b.windSpeed, sizeof(a.windSpeed)) == 0;
+}
+
+void checkIsolation() {
+    const size_t chunkRows = ConcurrentStore::CHUNK_ROWS;
+    ConcurrentStore store;
+    std::vector<Measurement> rows;
+    for (size_t i = 0; i < 2 * chunkRows + 100; i++) {
+        rows.push_back(row(static_cast<int>(i)));
+    }
+    store.append(rows);
+    ConcurrentStore::Snapshot first = store.snapshot();
+    std::vector<Measurement> firstRows = rows;
+    check(first.chunkCount() == 3 && first.chunk(2).ids.size() == 100, "chunks of a snapshot");
+
+    // Appends land in the partial chunk the snapshot shares
+    for (int i = 0; i < 50; i++) {
+        store.append(row(100000 + i));
+        rows.push_back(row(100000 + i));
+    }
+    check(holds(first, firstRows), "appends do not show in an older snapshot");
+    check(holds(store.snapshot(), rows), "appends show in a new snapshot");
+
+    ConcurrentStore::Snapshot beforeErase = store.snapshot();
+    std::vector<Measurement> beforeEraseRows = rows;
+    const size_t slots[] = {chunkRows + 3, 0, rows.size() - 4};
+    for (size_t slot : slots) {
+        store.erase(slot);
+        rows.erase(rows.begin() + slot);
+    }
+    check(holds(store.snapshot(), rows), "erase keeps the order of the other rows");
+    check(holds(beforeErase, beforeEraseRows) && holds(first, firstRows), "erase does not touch older snapshots");
+
+    std::vector<Measurement> replaced = {row(-1), row(-2), row(-3)};
+    store.assign(replaced);
+    check(holds(store.snapshot(), replaced), "assign replaces every row");
+    check(holds(beforeErase, beforeEraseRows) && holds(first, firstRows), "assign does not touch older snapshots");
+    check(store.size() == 3 && ConcurrentStore::Snapshot().empty(), "sizes");
+}
+
+// One writer appends row(i) in order while readers check every snapshot
+// against the same function, so a row read before it was fully written or
+// published shows up as a mismatch
+void checkReaders() {
+    ConcurrentStore store;
+    const int rows = 100000;
+    std::atomic<bool> done{false};
+    std::atomic<long> bad{0}, snapshots{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; r++) {
+        readers.emplace_back([&, r]() {
+            size_t lastSize = 0;
+            while (!done) {
+                ConcurrentStore::Snapshot snapshot = store.snapshot();
+                if (snapshot.size() < lastSize) bad++;
+                lastSize = snapshot.size();
+                for (size_t i = r; i < snapshot.size(); i += 1009) {
+                    if (!sameRow(snapshot.row(i), row(static_cast<int>(i)))) bad++;
+                }
+                if (!snapshot.empty() && !sameRow(snapshot.row(snapshot.size() - 1),
+                                                  row(static_cast<int>(snapshot.size() - 1)))) {
+                    bad++;
+                }
+                snapshots++;
+                std::this_thread::yield();
+            }
+        });
+    }
+    for (int i = 0; i < rows; i++) {
+        store.append(row(i));
+        // Let the readers in on a single core too
+        if (i % 1000 == 0) std::this_thread::yield();
+    }
+    done = true;
+    for (std::thread& reader : readers) reader.join();
+    check(bad == 0, "readers only see whole rows, in order");
+    check(snapshots > 0 && store.size() == static_cast<size_t>(rows), "readers ran");
+}
+
+// The same through WeatherStation, with deletes among the appends
+void checkStation() {
+    WeatherStation station;
+    station.enableConcurrentReads();
+    std::atomic<bool> done{false};
+    std::atomic<long> bad{0}, snapshots{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; r++) {
+        readers.emplace_back([&]() {
+            while (!done) {
+                ConcurrentStore::Snapshot snapshot = station.snapshot();
+                Analyzer::Summary a = Analyzer::summarize(snapshot);
+                std::this_thread::yield();
+                Analyzer::Summary b = Analyzer::summarize(snapshot);
+                if (!sameSummary(a, b) || a.count() != snapshot.size()) bad++;
+                for (size_t i = 0; i < snapshot.size(); i += 997) {
+                    Measurement m = snapshot.row(i);
+                    if (m.getHumidity() != m.getId() % 100) bad++;
+                }
+                snapshots++;
+            }
+        });
+    }
+    std::mt19937 rng(1);
+    for (int i = 0; i < 40000; i++) {
+        station.addMeasurement(row(i));
+        if (i % 50 == 49) station.removeMeasurement(static_cast<int>(rng() % i));
+        if (i % 15000 == 14999) station.removeIf([](const Measurement& m) { return m.getId() % 13 == 0; });
+        if (i % 1000 == 0) std::this_thread::yield();
+    }
+    done = true;
+    for (std::thread& reader : readers) reader.join();
+    check(bad == 0, "a station snapshot never changes under its readers");
+    check(snapshots > 0, "station readers ran");
+
+    ConcurrentStore::Snapshot snapshot = station.snapshot();
+    check(holds(snapshot, station.getMeasurements()), "the last snapshot matches the station's rows");
+    check(sameSummary(Analyzer::summarize(snapshot),
+                      Analyzer::summarize(station.getColumns(), Analyzer::Execution::Parallel)),
+          "summarize(snapshot) matches summarize(columns, Parallel)");
+}
+
+}
+
+int main() {
+    checkIsolation();
+    checkReaders();
+    checkStation();
+
+    if (failures > 0) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All ConcurrentStore checks passed\n");
+    return 0;
+}
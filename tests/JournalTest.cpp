@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Journal.h"
+#include "MeasurementColumns.h"
+#include "Timestamp.h"
+#include "WeatherStation.h"
+
+// Journal replay, run by ctest. Exits non-zero on failure. Covers records
+// coming back in LSN order, a torn or corrupt record at the end of the log
+// (cut off, and the LSNs carry on after it), damage in an older segment
+// (refused), checkpoints, and replay through WeatherStation.
+
+namespace {
+
+namespace fs = std::filesystem;
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (!ok) {
+        failures++;
+        printf("FAIL %s\n", what);
+    }
+}
+
+const size_t RECORD_BYTES = 40;
+
+Measurement row(int i) {
+    return Measurement(i, i * 0.5f, 50.0f + i % 40, i % 9 * 1.5f, Timestamp::fromCivil(2024, 6, 1) + i);
+}
+
+std::vector<fs::path> segments(const fs::path& base) {
+    std::vector<fs::path> found;
+    std::string prefix = base.filename().string() + ".wal.";
+    for (const fs::directory_entry& entry : fs::directory_iterator(base.parent_path())) {
+        if (entry.path().filename().string().compare(0, prefix.size(), prefix) == 0) {
+            found.push_back(entry.path());
+        }
+    }
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+void appendBytes(const fs::path& path, const std::string& bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    file << bytes;
+}
+
+void flipByte(const fs::path& path, uintmax_t at) {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekg(at);
+    char c = 0;
+    file.get(c);
+    file.seekp(at);
+    file.put(static_cast<char>(c ^ 0x01));
+}
+
+// Writes count Add records through a fresh open of base
+void writeRecords(const fs::path& base, int first, int count) {
+    Journal journal;
+    MeasurementColumns snapshot;
+    std::vector<Journal::Record> tail;
+    journal.open(base.string(), snapshot, tail);
+    for (int i = first; i < first + count; i++) {
+        journal.append(Journal::RecordType::Add, row(i));
+    }
+    journal.sync();
+    journal.close();
+}
+
+bool inOrder(const std::vector<Journal::Record>& tail, uint64_t firstLsn) {
+    for (size_t i = 0; i < tail.size(); i++) {
+        if (tail[i].lsn != firstLsn + i || tail[i].measurement.getId() != static_cast<int>(firstLsn + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void checkTornTail(const fs::path& directory) {
+    fs::path base = directory / "torn";
+    writeRecords(base, 1, 100);
+    std::vector<fs::path> files = segments(base);
+    check(files.size() == 1 && fs::file_size(files[0]) == 100 * RECORD_BYTES, "one segment of whole records");
+
+    // A write that stopped part way through the next record
+    appendBytes(files[0], std::string(17, '\x5a'));
+    Journal journal;
+    MeasurementColumns snapshot;
+    std::vector<Journal::Record> tail;
+    check(journal.open(base.string(), snapshot, tail), "open with a torn tail");
+    check(tail.size() == 100 && inOrder(tail, 1), "every whole record replays in order");
+    check(tail.size() == 100 && tail[99].measurement.getTemperature() == row(100).getTemperature(),
+          "records keep their fields");
+    check(fs::file_size(files[0]) == 100 * RECORD_BYTES, "the torn bytes are cut off");
+    check(journal.append(Journal::RecordType::Add, row(101)) == 101, "LSNs carry on after the tail");
+    check(journal.sync(), "sync after replay");
+    journal.close();
+
+    // A whole last record that fails its checksum is cut off too
+    files = segments(base);
+    fs::path newest = files.back();
+    appendBytes(newest, std::string(RECORD_BYTES, '\0'));
+    check(journal.open(base.string(), snapshot, tail), "open with a zeroed last record");
+    check(tail.size() == 101 && inOrder(tail, 1), "a zeroed record is dropped");
+    journal.close();
+    flipByte(newest, fs::file_size(newest) - 3);
+    check(journal.open(base.string(), snapshot, tail), "open with a corrupt last record");
+    check(tail.size() == 100 && inOrder(tail, 1), "a corrupt last record is dropped");
+    journal.close();
+}
+
+void checkOlderSegment(const fs::path& directory) {
+    fs::path base = directory / "older";
+    writeRecords(base, 1, 10);
+    writeRecords(base, 11, 10);
+    std::vector<fs::path> files = segments(base);
+    check(files.size() == 2, "each open starts a segment");
+    flipByte(files[0], 5 * RECORD_BYTES + 20);
+
+    Journal journal;
+    MeasurementColumns snapshot;
+    std::vector<Journal::Record> tail;
+    check(!journal.open(base.string(), snapshot, tail) && tail.empty(),
+          "damage before the newest segment refuses the journal");
+}
+
+void checkCheckpoint(const fs::path& directory) {
+    fs::path base = directory / "checkpoint";
+    Journal journal;
+    MeasurementColumns snapshot;
+    std::vector<Journal::Record> tail;
+    journal.open(base.string(), snapshot, tail);
+    MeasurementColumns columns;
+    for (int i = 1; i <= 50; i++) {
+        journal.append(Journal::RecordType::Add, row(i));
+        columns.append(row(i));
+    }
+    check(journal.checkpoint(columns) && journal.waitForCheckpoint(), "checkpoint");
+    for (int i = 51; i <= 60; i++) {
+        journal.append(Journal::RecordType::Add, row(i));
+    }
+    journal.sync();
+    journal.close();
+    appendBytes(segments(base).back(), std::string(9, '\x01'));
+
+    check(journal.open(base.string(), snapshot, tail), "open after a checkpoint");
+    check(snapshot.size() == 50 && snapshot.row(49).getId() == 50, "the snapshot holds the checkpointed rows");
+    check(tail.size() == 10 && inOrder(tail, 51), "only records after the checkpoint replay");
+    journal.close();
+}
+
+void checkStation(const fs::path& directory) {
+    fs::path base = directory / "station";
+    std::vector<Measurement> expected;
+    {
+        WeatherStation station;
+        check(station.openJournal(base.string()), "openJournal");
+        for (int i = 1; i <= 30; i++) {
+            station.addMeasurement(row(i));
+        }
+        station.removeMeasurement(7);
+        station.addMeasurement(row(7));
+        check(station.syncJournal(), "syncJournal");
+        expected = station.getMeasurements();
+        station.closeJournal();
+    }
+    appendBytes(segments(base).back(), std::string(RECORD_BYTES - 1, '\x7f'));
+
+    WeatherStation replayed;
+    check(replayed.openJournal(base.string()), "replay through WeatherStation");
+    const std::vector<Measurement>& rows = replayed.getMeasurements();
+    check(rows.size() == expected.size() &&
+          std::memcmp(rows.data(), expected.data(), rows.size() * sizeof(Measurement)) == 0,
+          "replayed rows match, in order");
+    check(replayed.getStatistics().count() == expected.size(), "statistics follow the replay");
+    replayed.closeJournal();
+}
+
+}
+
+int main() {
+    fs::path directory = fs::temp_directory_path() / "weather_station_journal_test";
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+
+    checkTornTail(directory);
+    checkOlderSegment(directory);
+    checkCheckpoint(directory);
+    checkStation(directory);
+
+    fs::remove_all(directory);
+    if (failures > 0) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All Journal checks passed\n");
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+#include "Reductions.h"
+
+// Accuracy checks for Reductions, run by ctest. Exits non-zero on failure.
+//
+// Bounds, with eps = 2^-53 and S1 = sum of |value|:
+//   Fast:         |sum - exact| <= (BLOCK_VALUES / 16 + 32) * eps * S1
+//                 (each lane adds BLOCK_VALUES / 16 values, then lanes and
+//                 blocks are folded with Neumaier)
+//   Compensated:  |sum - exact| <= 8 * eps * S1
+//   M2 (either):  |m2 - exact| <= 2 * BLOCK_VALUES * eps * exact
+// and every kernel the CPU has must give the same bits as Portable.
+
+namespace {
+
+const double EPS = std::ldexp(1.0, -53);
+
+int failures = 0;
+
+void check(bool ok, const char* what, const char* name, double error, double bound) {
+    if (!ok) {
+        failures++;
+        printf("FAIL %-28s %-12s error %.3e > bound %.3e\n", name, what, error, bound);
+    }
+}
+
+bool sameBits(const Reductions::Result& a, const Reductions::Result& b) {
+    return a.count == b.count &&
+           memcmp(&a.sum, &b.sum, sizeof(double)) == 0 &&
+           memcmp(&a.m2, &b.m2, sizeof(double)) == 0 &&
+           memcmp(&a.min, &b.min, sizeof(float)) == 0 &&
+           memcmp(&a.max, &b.max, sizeof(float)) == 0;
+}
+
+// extremes() must give reduce()'s min and max bit for bit
+void checkExtremes(const char* name, const std::vector<float>& values, Reductions::Kernel kernel,
+                   const Reductions::Result& reference) {
+    Reductions::Extremes extremes = Reductions::extremes(values, kernel);
+    bool same = extremes.empty == (reference.count == 0) &&
+                memcmp(&extremes.min, &reference.min, sizeof(float)) == 0 &&
+                memcmp(&extremes.max, &reference.max, sizeof(float)) == 0;
+    if (!same) {
+        failures++;
+        printf("FAIL %-28s extremes %s differ from reduce\n", name, Reductions::kernelName(kernel));
+    }
+}
+
+void checkColumn(const char* name, const std::vector<float>& values) {
+    long double exact = 0.0L, absolute = 0.0L;
+    for (float v : values) {
+        exact += v;
+        absolute += std::fabs(v);
+    }
+    long double mean = exact / values.size();
+    long double m2 = 0.0L;
+    for (float v : values) {
+        m2 += (v - mean) * (v - mean);
+    }
+
+    const Reductions::Summation modes[] = {Reductions::Summation::Fast, Reductions::Summation::Compensated};
+    const Reductions::Kernel kernels[] = {Reductions::Kernel::Portable, Reductions::Kernel::AVX2,
+                                          Reductions::Kernel::AVX512};
+    for (Reductions::Summation mode : modes) {
+        bool fast = mode == Reductions::Summation::Fast;
+        Reductions::Result reference = Reductions::reduce(values, Reductions::Kernel::Portable, mode);
+
+        double sumError = static_cast<double>(std::fabs(reference.sum - exact));
+        double sumBound = (fast ? Reductions::BLOCK_VALUES / 16 + 32 : 8) * EPS * static_cast<double>(absolute);
+        check(sumError <= sumBound, fast ? "fast sum" : "comp sum", name, sumError, sumBound);
+
+        double m2Error = static_cast<double>(std::fabs(reference.m2 - m2));
+        double m2Bound = 2.0 * Reductions::BLOCK_VALUES * EPS * static_cast<double>(m2);
+        check(m2Error <= m2Bound, fast ? "fast m2" : "comp m2", name, m2Error, m2Bound);
+
+        for (Reductions::Kernel kernel : kernels) {
+            if (kernel > Reductions::bestKernel()) break;
+            Reductions::Result result = Reductions::reduce(values, kernel, mode);
+            if (!sameBits(result, reference)) {
+                failures++;
+                printf("FAIL %-28s %s %s differs from Portable\n", name, fast ? "fast" : "compensated",
+                       Reductions::kernelName(kernel));
+            }
+            checkExtremes(name, values, kernel, reference);
+        }
+    }
+}
+
+// NaN values are skipped: the result must match the column without them,
+// in every kernel and with NaN in the head, the lanes and the tail
+void checkMissing(const char* name, std::vector<float> values, size_t stride) {
+    std::vector<float> present;
+    for (size_t i = 0; i < values.size(); i++) {
+        if (i % stride == 0) {
+            values[i] = std::numeric_limits<float>::quiet_NaN();
+        } else {
+            present.push_back(values[i]);
+        }
+    }
+    Reductions::Result expected = Reductions::reduce(present, Reductions::Kernel::Portable,
+                                                     Reductions::Summation::Compensated);
+    const Reductions::Kernel kernels[] = {Reductions::Kernel::Portable, Reductions::Kernel::AVX2,
+                                          Reductions::Kernel::AVX512};
+    for (Reductions::Kernel kernel : kernels) {
+        if (kernel > Reductions::bestKernel()) break;
+        Reductions::Result result = Reductions::reduce(values, kernel, Reductions::Summation::Compensated);
+        double sumError = std::fabs(result.sum - expected.sum);
+        double sumBound = 16 * EPS * std::fabs(expected.sum) + 1e-300;
+        double m2Error = std::fabs(result.m2 - expected.m2);
+        double m2Bound = 2.0 * Reductions::BLOCK_VALUES * EPS * expected.m2 + 1e-300;
+        bool ok = result.count == expected.count && result.min == expected.min && result.max == expected.max;
+        check(ok, "NaN count/min/max", name, 0.0, 0.0);
+        check(sumError <= sumBound, "NaN sum", name, sumError, sumBound);
+        check(m2Error <= m2Bound, "NaN m2", name, m2Error, m2Bound);
+        if (!sameBits(result, Reductions::reduce(values, Reductions::Kernel::Portable,
+                                                 Reductions::Summation::Compensated))) {
+            failures++;
+            printf("FAIL %-28s NaN %s differs from Portable\n", name, Reductions::kernelName(kernel));
+        }
+        checkExtremes(name, values, kernel, result);
+    }
+}
+
+std::vector<float> normal(size_t count, float mean, float deviation, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> distribution(mean, deviation);
+    std::vector<float> values(count);
+    for (float& v : values) v = distribution(rng);
+    return values;
+}
+
+}
+
+int main() {
+    printf("Reductions kernels up to %s\n", Reductions::kernelName(Reductions::bestKernel()));
+
+    // Lengths around the lane and block boundaries
+    const size_t lengths[] = {1, 15, 16, 17, 1000, Reductions::BLOCK_VALUES - 1, Reductions::BLOCK_VALUES,
+                              Reductions::BLOCK_VALUES + 1, 5000003};
+    char name[64];
+    for (size_t count : lengths) {
+        snprintf(name, sizeof(name), "temperature n=%zu", count);
+        checkColumn(name, normal(count, 12.0f, 9.0f, 7));
+    }
+
+    // Far from zero, where sum-of-squares formulas cancel
+    checkColumn("humidity near 100", normal(3000000, 99.5f, 0.3f, 11));
+    checkColumn("offset 1e4", normal(1000000, 1.0e4f, 0.5f, 13));
+    // Mixed signs that cancel in the sum
+    checkColumn("mean zero", normal(2000000, 0.0f, 1000.0f, 17));
+
+    std::vector<float> constant(100000, 3.7f);
+    checkColumn("constant", constant);
+
+    checkMissing("every 7th NaN", normal(Reductions::BLOCK_VALUES * 3 + 5, 12.0f, 9.0f, 19), 7);
+    checkMissing("all NaN", normal(100, 12.0f, 9.0f, 23), 1);
+
+    // Which zero wins a tie depends on the order values are compared in
+    std::vector<float> zeros(Reductions::BLOCK_VALUES * 2 + 40);
+    for (size_t i = 0; i < zeros.size(); i++) {
+        zeros[i] = (i * 7919) % 5 < 2 ? -0.0f : 0.0f;
+    }
+    checkColumn("signed zeros", zeros);
+
+    if (failures > 0) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All Reductions checks passed\n");
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <string>
+#include "MeasurementColumns.h"
+#include "Snapshot.h"
+#include "Timestamp.h"
+#include "WeatherStation.h"
+
+// Snapshot files, run by ctest. Exits non-zero on failure. Covers the
+// round trip of every column bit for bit, the stored sequence, corrupt and
+// truncated files, and saving and loading through WeatherStation.
+
+namespace {
+
+namespace fs = std::filesystem;
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (!ok) {
+        failures++;
+        printf("FAIL %s\n", what);
+    }
+}
+
+template <typename T>
+bool sameBits(std::span<const T> a, std::span<const T> b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size_bytes()) == 0;
+}
+
+bool sameColumns(const MeasurementColumns& a, const MeasurementColumns& b) {
+    return sameBits(a.getIds(), b.getIds()) && sameBits(a.getTemperatures(), b.getTemperatures()) &&
+           sameBits(a.getHumidities(), b.getHumidities()) && sameBits(a.getWindSpeeds(), b.getWindSpeeds()) &&
+           sameBits(a.getTimestamps(), b.getTimestamps());
+}
+
+MeasurementColumns sample(size_t rows) {
+    MeasurementColumns columns;
+    int64_t start = Timestamp::fromCivil(2024, 1, 1);
+    for (size_t i = 0; i < rows; i++) {
+        float temperature = i % 97 == 5 ? std::numeric_limits<float>::quiet_NaN() : -20.0f + (i % 400) * 0.125f;
+        // Ids repeat and go negative, wind speeds are denormal, timestamps
+        // go back now and then
+        int64_t timestamp = start + static_cast<int64_t>(i) * 10 - (i % 13 == 0 ? 30 : 0);
+        columns.append(Measurement(static_cast<int>(i % 1000) - 10, temperature, (i * 7) % 101 * 1.0f,
+                                   std::ldexp(1.0f, -140) * (i % 3), timestamp));
+    }
+    return columns;
+}
+
+std::string readFile(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void writeFile(const fs::path& path, const std::string& bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << bytes;
+}
+
+void checkRoundTrip(const fs::path& directory) {
+    fs::path path = directory / "round.wsnap";
+    MeasurementColumns columns = sample(100003);
+    check(Snapshot::save(path.string(), columns, 42), "save");
+    check(Snapshot::isSnapshotFile(path.string()), "isSnapshotFile");
+    check(!fs::exists(path.string() + ".tmp"), "no .tmp left behind");
+
+    MeasurementColumns loaded;
+    uint64_t sequence = 0;
+    check(Snapshot::load(path.string(), loaded, &sequence), "load");
+    check(sameColumns(columns, loaded), "every column comes back bit for bit");
+    check(sequence == 42, "sequence comes back");
+
+    MeasurementColumns empty;
+    check(Snapshot::save(path.string(), empty) && Snapshot::load(path.string(), loaded, &sequence) &&
+          loaded.empty() && sequence == 0, "empty columns round trip");
+}
+
+void checkCorruption(const fs::path& directory) {
+    fs::path path = directory / "corrupt.wsnap";
+    MeasurementColumns columns = sample(5000);
+    Snapshot::save(path.string(), columns);
+    std::string good = readFile(path);
+
+    MeasurementColumns kept = sample(10);
+    MeasurementColumns before = kept;
+    // A flipped bit in the header, the directory, and the last column
+    const size_t positions[] = {20, 50, good.size() - 3};
+    for (size_t at : positions) {
+        std::string bad = good;
+        bad[at] ^= 0x10;
+        check(!Snapshot::load(bad.data(), bad.data() + bad.size(), kept), "a flipped bit is rejected");
+    }
+    check(!Snapshot::load(good.data(), good.data() + good.size() / 2, kept), "a truncated file is rejected");
+    check(!Snapshot::load(good.data(), good.data() + 7, kept), "a few bytes are rejected");
+    check(sameColumns(kept, before), "a rejected load leaves the columns alone");
+
+    std::string text = "1;22.5;65;12.3;15/12/2024;03:00\n";
+    check(!Snapshot::isSnapshot(text.data(), text.data() + text.size()), "text is not a snapshot");
+}
+
+void checkStation(const fs::path& directory) {
+    fs::path path = directory / "station.wsnap";
+    WeatherStation station;
+    MeasurementColumns columns = sample(20000);
+    for (size_t i = 0; i < columns.size(); i++) {
+        station.addMeasurement(columns.row(i));
+    }
+    check(station.saveToFile(path.string(), WeatherStation::FileFormat::Snapshot), "station save");
+
+    WeatherStation loaded;
+    check(loaded.loadFromFile(path.string()), "station load");
+    check(loaded.getFileFormat() == WeatherStation::FileFormat::Snapshot, "format detected from the bytes");
+    check(sameColumns(loaded.getColumns(), station.getColumns()), "station round trip");
+    check(loaded.getMeasurements().size() == columns.size() &&
+          std::memcmp(loaded.getMeasurements().data(), station.getMeasurements().data(),
+                      columns.size() * sizeof(Measurement)) == 0, "rows round trip");
+
+    // A damaged snapshot does not replace the rows already loaded
+    writeFile(path, readFile(path).substr(0, 100));
+    check(!loaded.loadFromFile(path.string()) && loaded.getMeasurements().size() == columns.size(),
+          "a damaged file does not replace the rows");
+}
+
+}
+
+int main() {
+    fs::path directory = fs::temp_directory_path() / "weather_station_snapshot_test";
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+
+    checkRoundTrip(directory);
+    checkCorruption(directory);
+    checkStation(directory);
+
+    fs::remove_all(directory);
+    if (failures > 0) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All Snapshot checks passed\n");
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <vector>
+#include "Analyzer.h"
+#include "Timestamp.h"
+#include "WeatherStation.h"
+
+// NaN policy of the statistics, run by ctest. Exits non-zero on failure.
+// Every summary of the same rows must skip NaN the same way: the running
+// statistics, the rollups behind getStatistics(from, to), the row and
+// column summaries, the time-window helpers and the range aggregates.
+
+namespace {
+
+const float NOT_A_NUMBER = std::numeric_limits<float>::quiet_NaN();
+
+int failures = 0;
+const char* stage = "";
+
+void check(bool ok, const char* what) {
+    if (!ok) {
+        failures++;
+        printf("FAIL %s: %s\n", stage, what);
+    }
+}
+
+bool close(double a, double b) {
+    return std::fabs(a - b) <= 1e-9 * (1.0 + std::fabs(b));
+}
+
+bool sameField(const Analyzer::FieldStats& a, const Analyzer::FieldStats& b) {
+    if (a.count != b.count) return false;
+    if (a.count == 0) return true;
+    return close(a.mean, b.mean) && close(a.m2, b.m2) && a.min == b.min && a.max == b.max;
+}
+
+bool sameSummary(const Analyzer::Summary& a, const Analyzer::Summary& b) {
+    return sameField(a.temperature, b.temperature) && sameField(a.humidity, b.humidity) &&
+           sameField(a.windSpeed, b.windSpeed);
+}
+
+// The expected statistics, straight from the definition
+Analyzer::FieldStats reference(const std::vector<Measurement>& rows, float (Measurement::*get)() const) {
+    Analyzer::FieldStats stats;
+    double sum = 0.0;
+    for (const Measurement& m : rows) {
+        float v = (m.*get)();
+        if (std::isnan(v)) continue;
+        if (stats.count == 0 || v < stats.min) stats.min = v;
+        if (stats.count == 0 || v > stats.max) stats.max = v;
+        stats.count++;
+        sum += v;
+    }
+    if (stats.count == 0) return stats;
+    stats.mean = sum / stats.count;
+    for (const Measurement& m : rows) {
+        float v = (m.*get)();
+        if (!std::isnan(v)) stats.m2 += (v - stats.mean) * (v - stats.mean);
+    }
+    return stats;
+}
+
+void checkStation(const WeatherStation& station, const char* when) {
+    const std::vector<Measurement>& rows = station.getMeasurements();
+    Analyzer::Summary expected;
+    expected.temperature = reference(rows, &Measurement::getTemperature);
+    expected.humidity = reference(rows, &Measurement::getHumidity);
+    expected.windSpeed = reference(rows, &Measurement::getWindSpeed);
+
+    stage = when;
+    check(sameSummary(station.getStatistics(), expected), "running statistics");
+    check(sameSummary(station.getStatistics(INT64_MIN, INT64_MAX), expected), "rollups over every row");
+    check(sameSummary(Analyzer::summarize(rows), expected), "summarize(rows)");
+    check(sameSummary(Analyzer::summarize(station.getColumns()), expected), "summarize(columns)");
+    check(sameSummary(Analyzer::summarize(station.getColumns(), Analyzer::Execution::Parallel), expected),
+          "summarize(columns, Parallel)");
+    check(sameSummary(Analyzer::summarize(station.snapshot()), expected), "summarize(snapshot)");
+
+    TimeRange all = station.range(INT64_MIN, INT64_MAX);
+    check(sameSummary(Analyzer::summarize(all), expected), "summarize(range)");
+    if (expected.temperature.count > 0) {
+        check(Analyzer::minTemperature(all) == expected.temperature.min, "minTemperature(range)");
+        check(Analyzer::maxTemperature(all) == expected.temperature.max, "maxTemperature(range)");
+        check(close(Analyzer::averageTemperature(rows), static_cast<float>(expected.temperature.mean)),
+              "averageTemperature(rows)");
+        check(Analyzer::minimum(station.getColumns().getTemperatures()) == expected.temperature.min,
+              "minimum(column)");
+    }
+
+    RangeAggregateIndex::Aggregate aggregate =
+        station.aggregatePositions(RangeAggregateIndex::Field::Temperature, 0, rows.size());
+    check(aggregate.count == expected.temperature.count, "range aggregate count");
+    check(aggregate.count == 0 || (aggregate.min == expected.temperature.min &&
+                                   aggregate.max == expected.temperature.max &&
+                                   close(aggregate.mean(), expected.temperature.mean)),
+          "range aggregate values");
+}
+
+void checkMixed() {
+    WeatherStation station;
+    station.enableConcurrentReads();
+    int64_t start = Timestamp::fromCivil(2024, 3, 1);
+    std::vector<Measurement> batch;
+    for (int i = 0; i < 5000; i++) {
+        float temperature = i % 7 == 3 ? NOT_A_NUMBER : 10.0f + (i % 23) * 0.5f;
+        float humidity = i % 11 == 0 ? NOT_A_NUMBER : 40.0f + (i % 37);
+        // Hourly samples, so the rollups cover hours, days and months
+        batch.push_back(Measurement(i, temperature, humidity, 5.0f + (i % 5), start + i * 60));
+    }
+    station.addMeasurements(batch);
+    checkStation(station, "NaN mixed in");
+
+    station.removeIf([](const Measurement& m) { return m.getId() % 3 == 0; });
+    checkStation(station, "after deletes");
+
+    station.addMeasurement(Measurement(9000, NOT_A_NUMBER, NOT_A_NUMBER, NOT_A_NUMBER, start + 100));
+    checkStation(station, "after an all-NaN row");
+}
+
+void checkAllMissing() {
+    WeatherStation station;
+    station.enableConcurrentReads();
+    int64_t start = Timestamp::fromCivil(2024, 3, 1);
+    for (int i = 0; i < 50; i++) {
+        station.addMeasurement(Measurement(i, NOT_A_NUMBER, 60.0f, 3.0f, start + i));
+    }
+    checkStation(station, "no temperatures");
+    Analyzer::Summary summary = station.getStatistics();
+    check(summary.temperature.count == 0, "temperature count is 0");
+    check(summary.count() == 50, "count() is not 0 while other fields have values");
+    check(station.getStatistics(start, start + 50).count() == 50, "window count() too");
+}
+
+}
+
+int main() {
+    checkMixed();
+    checkAllMissing();
+
+    if (failures > 0) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All statistics checks passed\n");
+    return 0;
+}
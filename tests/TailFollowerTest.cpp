@@ -0,0 +1,104 @@
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "TailFollower.h"
+#include "WeatherStation.h"
+
+// Text loading and TailFollower, run by ctest. Exits non-zero on failure.
+// Covers a last line without its '\n' (kept by a plain load, left to the
+// follower by a complete-lines load), partial lines across polls,
+// truncation and rotation.
+
+namespace {
+
+namespace fs = std::filesystem;
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (!ok) {
+        failures++;
+        printf("FAIL %s\n", what);
+    }
+}
+
+void write(const fs::path& path, const std::string& text, bool append = false) {
+    std::ofstream file(path, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+    file << text;
+}
+
+const char* const LINE1 = "1;22.5;65;12.3;15/12/2024;03:00\n";
+const char* const LINE2 = "2;18.3;72.5;8.7;16/12/2024;13:00\n";
+const char* const LINE3 = "3;25.1;58;15.2;17/12/2024;13:56\n";
+
+void checkLoads(const fs::path& path) {
+    const WeatherStation::LoadMode modes[] = {WeatherStation::LoadMode::Stream, WeatherStation::LoadMode::Mapped,
+                                              WeatherStation::LoadMode::Parallel};
+    std::string unterminated = std::string(LINE1) + LINE2 + "3;25.1;58;15.2;17/12/2024;13:56";
+    size_t boundary = std::string(LINE1).size() + std::string(LINE2).size();
+    for (WeatherStation::LoadMode mode : modes) {
+        write(path, unterminated);
+        WeatherStation station;
+        check(station.loadFromFile(path.string(), mode), "plain load");
+        check(station.getMeasurements().size() == 3, "plain load keeps a last line without '\\n'");
+        check(station.getLastLoadStats().lineEnd == boundary, "lineEnd is past the last '\\n'");
+        check(station.getLastLoadStats().bytes == unterminated.size(), "bytes is the file size");
+
+        WeatherStation partial;
+        check(partial.loadFromFile(path.string(), mode, true), "complete-lines load");
+        check(partial.getMeasurements().size() == 2, "complete-lines load stops at the last '\\n'");
+
+        write(path, std::string(LINE1) + LINE2);
+        WeatherStation terminated;
+        terminated.loadFromFile(path.string(), mode, true);
+        check(terminated.getMeasurements().size() == 2, "terminated file loads every line");
+        check(terminated.getLastLoadStats().lineEnd == boundary, "terminated lineEnd is the file size");
+    }
+}
+
+void checkFollow(const fs::path& path) {
+    // A writer in the middle of line 3 while the file is loaded
+    write(path, std::string(LINE1) + LINE2 + "3;25.1;5");
+    WeatherStation station;
+    station.loadFromFile(path.string(), WeatherStation::LoadMode::Mapped, true);
+    TailFollower follower;
+    check(follower.open(path.string(), station.getLastLoadStats().lineEnd), "open at lineEnd");
+    check(follower.poll(station) == 0, "an unfinished line waits");
+
+    write(path, "8;15.2;17/12/2024;13:56\n", true);
+    check(follower.poll(station) == 1, "the finished line is added once");
+    check(station.getMeasurements().size() == 3, "three rows after the first line ends");
+    check(station.getMeasurements().back().getHumidity() == 58.0f, "the line is parsed whole");
+
+    // Truncated and rewritten in place: read again from byte 0
+    write(path, LINE1);
+    check(follower.poll(station) == 1, "truncation rereads from the start");
+
+    // Rotated: the old file is finished even without a '\n', then the new one is read
+    write(path, "4;10;50;1;18/12/2024;00:00", true);
+    fs::rename(path, path.string() + ".1");
+    write(path, LINE3);
+    check(follower.poll(station) == 2, "rotation finishes the old file and reads the new one");
+    check(station.getMeasurements().back().getId() == 3, "the new file comes last");
+    check(follower.getOffset() == std::string(LINE3).size(), "offset is into the new file");
+}
+
+}
+
+int main() {
+    fs::path directory = fs::temp_directory_path() / "weather_station_tail_test";
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+
+    checkLoads(directory / "load.txt");
+    checkFollow(directory / "follow.txt");
+
+    fs::remove_all(directory);
+    if (failures > 0) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All TailFollower checks passed\n");
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Measurement.h"
+#include "MeasurementParser.h"
+#include "Timestamp.h"
+#include "WeatherStation.h"
+
+// Timestamp, Measurement text lines and MeasurementParser, run by ctest.
+// Exits non-zero on failure.
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (!ok) {
+        failures++;
+        printf("FAIL %s\n", what);
+    }
+}
+
+bool parses(const std::string& date, const std::string& time) {
+    int64_t minutes;
+    return Timestamp::parse(date, time, minutes);
+}
+
+void checkTimestamp() {
+    int64_t minutes = -1;
+    check(Timestamp::parse("01/01/1970", "00:00", minutes) && minutes == 0, "epoch");
+    check(Timestamp::parse("15/12/2024", "03:07", minutes) &&
+          minutes == Timestamp::fromCivil(2024, 12, 15, 3, 7), "parse matches fromCivil");
+    check(Timestamp::dateString(minutes) == "15/12/2024" && Timestamp::timeString(minutes) == "03:07",
+          "format gives back the text");
+    check(Timestamp::parse("31/12/1969", "23:59", minutes) && minutes == -1, "before the epoch");
+    check(Timestamp::dateString(-1) == "31/12/1969", "format before the epoch");
+
+    check(parses("29/02/2024", "12:00"), "29/02 in a leap year");
+    check(parses("29/02/2000", "12:00"), "29/02/2000");
+    check(!parses("29/02/1900", "12:00"), "no 29/02/1900");
+    check(!parses("29/02/2023", "12:00"), "no 29/02/2023");
+    check(!parses("31/04/2024", "12:00"), "no 31/04");
+    check(!parses("00/01/2024", "12:00"), "no day 0");
+    check(!parses("01/13/2024", "12:00"), "no month 13");
+    check(!parses("01/01/2024", "24:00"), "no hour 24");
+    check(!parses("01/01/2024", "12:60"), "no minute 60");
+
+    // Only the canonical widths, so a parsed value formats back unchanged
+    check(!parses("1/1/5", "00:00"), "short date fields");
+    check(!parses("01/01/24", "00:00"), "two-digit year");
+    check(!parses("01/01/2024", "1:05"), "one-digit hour");
+    check(!parses("01/01/2024x", "00:00"), "trailing text");
+    check(!parses("", "00:00"), "empty date");
+
+    minutes = 42;
+    check(!Timestamp::parse("bad", "00:00", minutes) && minutes == 42, "output untouched on failure");
+
+    int64_t monday = Timestamp::fromCivil(2024, 12, 16);
+    check(Timestamp::startOfWeek(Timestamp::fromCivil(2024, 12, 22, 23, 59)) == monday, "week starts on Monday");
+    check(Timestamp::startOfMonth(Timestamp::fromCivil(2024, 2, 29, 8)) == Timestamp::fromCivil(2024, 2, 1),
+          "start of month");
+
+    Measurement m(1, 0.0f, 0.0f, 0.0f, Timestamp::fromCivil(2024, 5, 6, 7, 8));
+    check(!m.setDate("32/01/2024") && m.getDate() == "06/05/2024", "setDate rejects and keeps the date");
+    check(!m.setTime("7:8") && m.getTime() == "07:08", "setTime rejects and keeps the time");
+    check(m.setDate("01/02/2024") && m.getDate() == "01/02/2024" && m.getTime() == "07:08", "setDate keeps the time");
+}
+
+void checkParser() {
+    Measurement m;
+    const char* line = "7;-3.5;81;12.25;24/12/2024;18:30";
+    check(MeasurementParser::parseLine(line, line + strlen(line), m), "parseLine");
+    check(m.getId() == 7 && m.getTemperature() == -3.5f && m.getHumidity() == 81.0f &&
+          m.getWindSpeed() == 12.25f && m.getTimestamp() == Timestamp::fromCivil(2024, 12, 24, 18, 30),
+          "parseLine fields");
+    check(m.toTextLine() == line, "toTextLine gives back the line");
+
+    const char* legacy = "8;1;2;3;24/12/2024";
+    check(MeasurementParser::parseLine(legacy, legacy + strlen(legacy), m) &&
+          m.getTimestamp() == Timestamp::fromCivil(2024, 12, 24), "a missing time is 00:00");
+    const char* badDate = "9;1;2;3;24/13/2024;10:00";
+    check(!MeasurementParser::parseLine(badDate, badDate + strlen(badDate), m), "parseLine rejects a bad date");
+    const char* noDate = "9;1;2;3";
+    check(!MeasurementParser::parseLine(noDate, noDate + strlen(noDate), m), "parseLine rejects a missing date");
+
+    std::string text = "1;1;1;1;01/01/2024;00:00\r\n"
+                       "\n"
+                       "2;2;2;2;31/02/2024;00:00\n"
+                       "3;3;3;3;02/01/2024;25:00\n"
+                       "4;4;4;4;03/01/2024;\n"
+                       "5;5;5;5;04/01/2024;05:05";
+    std::vector<Measurement> out;
+    size_t rejected = 0;
+    size_t parsed = MeasurementParser::parseBuffer(text.data(), text.data() + text.size(), out, &rejected);
+    check(parsed == 3 && out.size() == 3 && rejected == 2, "parseBuffer skips and counts bad rows");
+    check(out.size() == 3 && out[0].getId() == 1 && out[1].getId() == 4 && out[2].getId() == 5,
+          "parseBuffer keeps the good rows in order");
+    check(out.size() == 3 && out[2].getTime() == "05:05", "a last line without '\\n' is parsed");
+
+    // Enough text for several chunks; parallel must match serial exactly
+    std::string big;
+    char row[Measurement::MAX_TEXT_LINE + 1];
+    for (int i = 0; i < 200000; i++) {
+        Measurement r(i, i * 0.25f - 40.0f, static_cast<float>(i % 101), i * 0.5f, Timestamp::fromCivil(2024, 1, 1) + i);
+        char* end = r.formatTextLine(row);
+        if (i % 1000 == 999) {
+            memcpy(end - 5, "99:99", 5);
+        }
+        big.append(row, end);
+        big += '\n';
+    }
+    std::vector<Measurement> serial, parallel;
+    size_t serialRejected = 0, parallelRejected = 0;
+    MeasurementParser::parseBuffer(big.data(), big.data() + big.size(), serial, &serialRejected);
+    MeasurementParser::parseBufferParallel(big.data(), big.data() + big.size(), parallel, 4, &parallelRejected);
+    check(serialRejected == 200 && parallelRejected == 200, "rejected counts across chunks");
+    check(serial.size() == parallel.size() &&
+          memcmp(serial.data(), parallel.data(), serial.size() * sizeof(Measurement)) == 0,
+          "parallel parse matches serial");
+}
+
+void checkLoaders() {
+    namespace fs = std::filesystem;
+    fs::path path = fs::temp_directory_path() / "weather_station_text_test.txt";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "1;22.5;65;12.3;15/12/2024;03:00\r\n"
+                "2;18.3;72.5;8.7;1/1/5;13:00\n"
+                "3;25.1;58;15.2;17/12/2024\n"
+                "4;25.1;58;15.2;17/12/2024;13:56";
+    }
+    const WeatherStation::LoadMode modes[] = {WeatherStation::LoadMode::Stream, WeatherStation::LoadMode::Mapped,
+                                              WeatherStation::LoadMode::Parallel};
+    std::vector<Measurement> first;
+    for (WeatherStation::LoadMode mode : modes) {
+        WeatherStation station;
+        check(station.loadFromFile(path.string(), mode), "load");
+        const std::vector<Measurement>& rows = station.getMeasurements();
+        check(rows.size() == 3 && station.getLastLoadStats().rejected == 1, "loaders skip and count bad rows");
+        if (first.empty()) {
+            first = rows;
+        } else {
+            check(rows.size() == first.size() && memcmp(rows.data(), first.data(), rows.size() * sizeof(Measurement)) == 0,
+                  "every load mode gives the same rows");
+        }
+    }
+    fs::remove(path);
+}
+
+}
+
+int main() {
+    checkTimestamp();
+    checkParser();
+    checkLoaders();
+
+    if (failures > 0) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All text format checks passed\n");
+    return 0;
+}